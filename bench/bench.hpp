@@ -0,0 +1,101 @@
+#ifndef HSM_BENCH_HPP
+#define HSM_BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace bench {
+
+class Stopwatch {
+	std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+
+public:
+	double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count(); }
+	void   reset() { start_ = std::chrono::steady_clock::now(); }
+};
+
+// Hardware dTLB load-miss counter; reports unavailable where perf events are not accessible
+class TlbCounter {
+#if defined(__linux__)
+	int fd_ = -1;
+
+public:
+	TlbCounter() {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size           = sizeof(attr);
+		attr.type           = PERF_TYPE_HW_CACHE;
+		attr.config         = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attr.disabled       = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		fd_                 = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+	}
+	~TlbCounter() {
+		if (fd_ >= 0) { close(fd_); }
+	}
+
+	bool available() const { return fd_ >= 0; }
+	void start() {
+		if (fd_ < 0) { return; }
+		ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	std::uint64_t stop() {
+		std::uint64_t value = 0;
+		if (fd_ < 0) { return 0; }
+		ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) { return 0; }
+		return value;
+	}
+#else
+public:
+	bool          available() const { return false; }
+	void          start() {}
+	std::uint64_t stop() { return 0; }
+#endif
+};
+
+// Small xorshift generator so runs are reproducible across standard libraries
+class Rng {
+	std::uint64_t s_;
+
+public:
+	explicit Rng(std::uint64_t seed) : s_(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+	std::uint64_t next() {
+		s_ ^= s_ << 13;
+		s_ ^= s_ >> 7;
+		s_ ^= s_ << 17;
+		return s_;
+	}
+	std::uint32_t below(std::uint32_t n) { return static_cast<std::uint32_t>(next() % n); }
+};
+
+// Resident set size of the process in bytes; 0 where it cannot be read
+inline std::uint64_t resident_bytes() {
+#if defined(__linux__)
+	unsigned long long pages = 0, resident = 0;
+	FILE              *f     = std::fopen("/proc/self/statm", "r");
+	if (!f) { return 0; }
+	const int n = std::fscanf(f, "%llu %llu", &pages, &resident);
+	std::fclose(f);
+	return n == 2 ? resident * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+	return 0;
+#endif
+}
+
+}  // namespace bench
+
+#endif  // HSM_BENCH_HPP
@@ -0,0 +1,139 @@
+// Fleet-scale run of the dist_agent lifecycle: events/s, resident memory per agent and transition latency.
+// Usage: bench_fleet [agents] [events] [seed] [audit_depth]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "agent.hpp"
+#include "bench.hpp"
+
+using namespace agent;
+
+namespace {
+
+std::size_t   audit_depth = 0;  // Entries each agent keeps, oldest dropped first; 0 keeps them all
+std::uint64_t audited     = 0;  // Entries written across the fleet
+
+}  // namespace
+
+// Audit entries are formatted and stored as the example does, but bounded per agent and never echoed
+void agent::log_audit(Machine &sm, const std::string &action) {
+	std::vector<std::string> &log = sm->audit_log;
+	if (audit_depth && log.size() == audit_depth) { log.erase(log.begin()); }
+	log.push_back("[" + sm->agent_name + "] " + action);
+	audited++;
+}
+
+void agent::trace(const char *, const char *) {}
+
+namespace {
+
+// Lifecycle mix, in percent, chosen from the agent's current state. A few events do not apply to the state the
+// agent is in and are passed over, as stale requests are in production.
+void drive(Machine &sm, bench::Rng &rng) {
+	const std::uint32_t roll = rng.below(100);
+	switch (sm.current_state_id()) {
+		case StateID::PENDING:
+			if (roll < 90) {
+				sm.dispatch(Approve{});
+			} else {
+				sm.dispatch(Reject{});
+			}
+			break;
+		case StateID::ACTIVE:
+			if (roll < 55) {
+				sm.dispatch(Suspend{});
+			} else if (roll < 60) {
+				sm.dispatch(Remove{});
+			} else {
+				sm.dispatch(Resume{});
+			}
+			break;
+		case StateID::SUSPENDED:
+			if (roll < 85) {
+				sm.dispatch(Resume{});
+			} else if (roll < 95) {
+				sm.dispatch(Remove{});
+			} else {
+				sm.dispatch(Suspend{});
+			}
+			break;
+		case StateID::REMOVED:
+			// A removed agent is re-registered, keeping the fleet size steady
+			sm.transition(StateID::PENDING);
+			break;
+	}
+}
+
+double percentile(std::vector<double> &v, double p) {
+	if (v.empty()) { return 0; }
+	return v[static_cast<std::size_t>(p * (v.size() - 1))];
+}
+
+// One event in this many is timed on its own, keeping clock reads out of the throughput figure
+enum : std::uint64_t { SAMPLE_EVERY = 64 };
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	const std::size_t   agents = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	const std::size_t   events = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+	const std::uint64_t seed   = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+	// Each agent formats and stores its audit entries as the example does, keeping the newest `depth` of them so a
+	// long run fits in memory; 0 keeps the whole log. Nothing is echoed to the console.
+	const std::size_t depth = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 4;
+	audit_depth             = depth;
+
+	const std::uint64_t                   before = bench::resident_bytes();
+	bench::Stopwatch                      setup;
+	std::vector<std::unique_ptr<Machine>> fleet;
+	fleet.reserve(agents);
+	for (std::size_t i = 0; i < agents; ++i) {
+		fleet.emplace_back(new Machine());
+		Traits::Context &ctx = fleet.back()->context();
+		ctx.agent_name       = "Agent-" + std::to_string(i);
+		fleet.back()->start(StateID::PENDING, build);
+	}
+	const double        setup_seconds = setup.seconds();
+	const std::uint64_t after         = bench::resident_bytes();
+
+	bench::Rng          rng(seed);
+	std::vector<double> latency;
+	latency.reserve(events / SAMPLE_EVERY + 1);
+	bench::Stopwatch clock;
+	for (std::size_t i = 0; i < events; ++i) {
+		Machine &sm = *fleet[rng.below(static_cast<std::uint32_t>(agents))];
+		if (i % SAMPLE_EVERY) {
+			drive(sm, rng);
+			continue;
+		}
+		const StateID from  = sm.current_state_id();
+		const auto    start = std::chrono::steady_clock::now();
+		drive(sm, rng);
+		const auto stop = std::chrono::steady_clock::now();
+		if (sm.current_state_id() != from) { latency.push_back(std::chrono::duration<double, std::nano>(stop - start).count()); }
+	}
+	const double elapsed = clock.seconds();
+
+	std::vector<std::size_t> by_state(4);
+	for (const auto &sm : fleet) {
+		by_state[static_cast<std::size_t>(sm->current_state_id())]++;
+	}
+	std::sort(latency.begin(), latency.end());
+
+	printf("agents       %zu (setup %.2f s, audit depth %zu)\n", agents, setup_seconds, depth);
+	if (after > before) {
+		printf("memory       %.0f bytes resident per agent\n", double(after - before) / agents);
+	} else {
+		printf("memory       (resident size unavailable)\n");
+	}
+	printf("throughput   %.2f Mevents/s over %zu events (seed %llu)\n", events / elapsed / 1e6, events, static_cast<unsigned long long>(seed));
+	printf("transition   p50 %.0f ns  p90 %.0f ns  p99 %.0f ns  p99.9 %.0f ns  (%zu samples)\n", percentile(latency, 0.50), percentile(latency, 0.90),
+		   percentile(latency, 0.99), percentile(latency, 0.999), latency.size());
+	printf("final mix    pending %zu  active %zu  suspended %zu  removed %zu  (audit entries %llu)\n", by_state[0], by_state[1], by_state[2], by_state[3],
+		   static_cast<unsigned long long>(audited));
+}
@@ -0,0 +1,108 @@
+// Dispatch throughput and dTLB misses for a large fleet, with and without huge-page-backed storage.
+// Usage: bench_hugepage [machines] [events]
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "bench.hpp"
+#include "hsm/hugepage.hpp"
+
+namespace {
+
+struct Event {
+	virtual ~Event() = default;
+};
+struct Toggle : Event {};
+struct Nudge : Event {};
+
+struct Traits {
+	using StateID = int;
+	using Event   = ::Event;
+	struct Context {
+		std::uint64_t toggles = 0;
+		std::uint64_t nudges  = 0;
+	};
+};
+
+using Machine = hsm::Machine<Traits>;
+using Scope   = hsm::Scope<Traits>;
+
+enum { GROUP, OFF, ON };
+
+hsm::Result on_group(Machine &sm, const Event &ev) {
+	return hsm::match(sm, ev).on<Nudge>([](Machine &sm, const Nudge &) {
+		sm->nudges++;
+		return hsm::Result::Done;
+	});
+}
+
+template <int Next>
+hsm::Result on_leaf(Machine &sm, const Event &ev) {
+	return hsm::match(sm, ev).on<Toggle>([](Machine &sm, const Toggle &) {
+		sm->toggles++;
+		sm.transition(Next);
+		return hsm::Result::Done;
+	});
+}
+
+void build(Scope &s) {
+	s.state(GROUP).handle(on_group).with([](Scope &s) {
+		s.state(OFF).handle(on_leaf<ON>);
+		s.state(ON).handle(on_leaf<OFF>);
+	});
+}
+
+void run(const char *label, std::vector<hsm::Owned<Machine>> &fleet, std::size_t events) {
+	bench::Rng        rng(42);
+	bench::TlbCounter tlb;
+	bench::Stopwatch  clock;
+	tlb.start();
+	for (std::size_t i = 0; i < events; ++i) {
+		auto &sm = *fleet[rng.below(static_cast<std::uint32_t>(fleet.size()))];
+		if (rng.next() & 1) {
+			sm.dispatch(Toggle{});
+		} else {
+			sm.dispatch(Nudge{});
+		}
+	}
+	const std::uint64_t misses  = tlb.stop();
+	const double        elapsed = clock.seconds();
+
+	printf("%-12s %10.2f Mevents/s", label, events / elapsed / 1e6);
+	if (tlb.available()) {
+		printf("  %8.3f dTLB misses/event\n", double(misses) / events);
+	} else {
+		printf("  (dTLB counter unavailable)\n");
+	}
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	const std::size_t machines = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+	const std::size_t events   = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5000000;
+
+	{
+		std::vector<hsm::Owned<Machine>> fleet;
+		fleet.reserve(machines);
+		for (std::size_t i = 0; i < machines; ++i) {
+			fleet.push_back(hsm::make_owned<Machine>(*hsm::default_resource()));
+			fleet.back()->start(OFF, build);
+		}
+		run("default", fleet, events);
+	}
+
+	{
+		hsm::HugePageResource            resource;
+		std::vector<hsm::Owned<Machine>> fleet;
+		fleet.reserve(machines);
+		for (std::size_t i = 0; i < machines; ++i) {
+			fleet.push_back(hsm::make_owned<Machine>(resource, hsm::WithResource(resource)));
+			fleet.back()->start(OFF, build);
+		}
+		static const char *const backing[] = {"none", "hugetlb", "thp", "regular"};
+		printf("huge pages: %s, %zu MiB mapped\n", backing[static_cast<int>(resource.backing())], resource.mapped() >> 20);
+		run("hugepage", fleet, events);
+	}
+}
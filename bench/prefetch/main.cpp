@@ -0,0 +1,121 @@
+// Executor throughput over a fleet much larger than the last-level cache, without and with lookahead prefetch.
+// Usage: bench_prefetch [machines] [rounds] [depth]
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "hsm/executor.hpp"
+
+namespace {
+
+struct Event {
+	virtual ~Event() = default;
+};
+struct Work : Event {};
+
+struct Traits {
+	using StateID = int;
+	using Event   = ::Event;
+	struct Context {
+		std::uint64_t handled = 0;
+		char          payload[192];  // Typical per-agent state, so every machine spans several cache lines
+	};
+};
+
+using Machine  = hsm::Machine<Traits>;
+using Scope    = hsm::Scope<Traits>;
+using Executor = hsm::Executor<Traits>;
+
+enum { IDLE, BUSY };
+
+std::atomic<std::uint64_t> handled{0};
+
+void build(Scope &s) {
+	s.state(IDLE).handle([](Machine &sm, const Event &) {
+		sm->handled++;
+		sm->payload[sm->handled % sizeof(sm->payload)]++;
+		sm.transition(BUSY);
+		handled.fetch_add(1, std::memory_order_relaxed);
+		return hsm::Result::Done;
+	});
+	s.state(BUSY).handle([](Machine &sm, const Event &) {
+		sm->handled++;
+		sm.transition(IDLE);
+		handled.fetch_add(1, std::memory_order_relaxed);
+		return hsm::Result::Done;
+	});
+}
+
+// Events posted straight into each inbox before the executor is told, so the worker has real work per machine
+enum { PRELOAD = 3 };
+
+// Holds the worker inside its handler until released, so the whole fleet queues up behind it
+std::atomic<bool> gate_open{false};
+
+void gate(Scope &s) {
+	s.state(IDLE).handle([](Machine &, const Event &) {
+		while (!gate_open.load(std::memory_order_acquire)) { std::this_thread::yield(); }
+		return hsm::Result::Done;
+	});
+}
+
+double run(std::vector<std::unique_ptr<Machine>> &fleet, std::size_t rounds, std::size_t depth) {
+	Machine barrier;
+	barrier.start(IDLE, gate);
+	Executor                      executor(1);
+	std::vector<Executor::Handle> handles;
+	for (auto &sm : fleet) { handles.push_back(executor.add(*sm, 0)); }
+	const Executor::Handle held = executor.add(barrier, 0);
+	executor.lookahead(depth);
+
+	// Visit machines in a fixed random order so neighbours in the run queue are not neighbours in memory
+	bench::Rng rng(11);
+	std::vector<std::size_t> order(fleet.size());
+	for (std::size_t i = 0; i < order.size(); ++i) { order[i] = i; }
+	for (std::size_t i = order.size(); i > 1; --i) { std::swap(order[i - 1], order[rng.below(i)]); }
+
+	double seconds = 0;
+	for (std::size_t r = 0; r < rounds; ++r) {
+		// Machines requeued at the end of the last round may run some of these before the clock starts
+		const std::uint64_t target = handled.load() + fleet.size() * (PRELOAD + 1);
+		for (std::size_t i : order) {
+			for (int k = 0; k < PRELOAD; ++k) { fleet[i]->post(Work{}); }
+		}
+
+		// Fill the run queue while the worker is parked, so the timed part drains a queue as deep as the fleet
+		gate_open.store(false);
+		executor.post(held, Work{});
+		for (std::size_t i : order) { executor.post(handles[i], Work{}); }
+
+		bench::Stopwatch clock;
+		gate_open.store(true, std::memory_order_release);
+		while (handled.load(std::memory_order_relaxed) < target) { std::this_thread::yield(); }
+		seconds += clock.seconds();
+	}
+	return double(fleet.size() * (PRELOAD + 1) * rounds) / seconds;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	const std::size_t machines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+	const std::size_t rounds   = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5;
+	const std::size_t depth    = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 8;
+
+	std::vector<std::unique_ptr<Machine>> fleet;
+	for (std::size_t i = 0; i < machines; ++i) {
+		fleet.emplace_back(new Machine());
+		fleet.back()->start(IDLE, build);
+	}
+	printf("%zu machines, %zu bytes each before heap state\n", machines, sizeof(Machine));
+
+	const double plain      = run(fleet, rounds, 0);
+	const double pipelined  = run(fleet, rounds, depth);
+	printf("lookahead 0   %12.0f events/s\n", plain);
+	printf("lookahead %-3zu %12.0f events/s  (%+.1f%%)\n", depth, pipelined, (pipelined / plain - 1) * 100);
+}
@@ -0,0 +1,87 @@
+// Throughput of a skewed fleet on an executor, with and without the load monitor migrating machines.
+// Usage: bench_rebalance [shards] [machines] [milliseconds]
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "bench.hpp"
+#include "hsm/executor.hpp"
+
+namespace {
+
+struct Event {
+	virtual ~Event() = default;
+};
+struct Request : Event {};
+
+struct Traits {
+	using StateID = int;
+	using Event   = ::Event;
+	struct Context {
+		std::uint64_t served = 0;
+	};
+};
+
+using Machine  = hsm::Machine<Traits>;
+using Scope    = hsm::Scope<Traits>;
+using Executor = hsm::Executor<Traits>;
+
+enum { SERVING };
+
+void build(Scope &s) {
+	s.state(SERVING).handle([](Machine &sm, const Event &) {
+		// Stand-in for per-request work
+		volatile std::uint64_t x = sm->served;
+		for (int i = 0; i < 2000; ++i) { x = x * 6364136223846793005ull + 1; }
+		sm->served++;
+		return hsm::Result::Done;
+	});
+}
+
+void run(const char *label, std::size_t shards, std::size_t machines, long long millis, std::chrono::milliseconds period) {
+	std::vector<std::unique_ptr<Machine>> fleet;
+	Executor                              executor(shards, period);
+	std::vector<Executor::Handle>         handles;
+	for (std::size_t i = 0; i < machines; ++i) {
+		fleet.emplace_back(new Machine());
+		fleet.back()->start(SERVING, build);
+		// Popular tenants all hash to shard 0
+		handles.push_back(executor.add(*fleet.back(), i < machines / 4 ? 0 : i % shards));
+	}
+
+	bench::Rng                  rng(11);
+	bench::Stopwatch            clock;
+	std::deque<Machine::Ticket> window;
+	std::uint64_t               posted = 0;
+	while (clock.seconds() * 1000 < millis) {
+		// 80% of the traffic goes to the popular quarter of the fleet
+		const std::size_t hot    = machines / 4 ? machines / 4 : 1;
+		const std::size_t target = rng.below(10) < 8 ? rng.below(static_cast<std::uint32_t>(hot)) : rng.below(static_cast<std::uint32_t>(machines));
+		window.push_back(executor.post(handles[target], Request{}));
+		++posted;
+		if (window.size() > 4096) {
+			window.front().wait();
+			window.pop_front();
+		}
+	}
+	while (!window.empty()) {
+		window.front().wait();
+		window.pop_front();
+	}
+	const double elapsed = clock.seconds();
+
+	printf("%-12s %10.2f kevents/s  %6llu migrations\n", label, posted / elapsed / 1e3, static_cast<unsigned long long>(executor.migrations()));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	const std::size_t shards   = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+	const std::size_t machines = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+	const long long   millis   = argc > 3 ? std::strtoll(argv[3], nullptr, 10) : 2000;
+
+	run("pinned", shards, machines, millis, std::chrono::milliseconds::zero());
+	run("rebalanced", shards, machines, millis, std::chrono::milliseconds(50));
+}
@@ -0,0 +1,103 @@
+// p99 latency of a quiet tenant next to a flooding one, with one shared tenant versus weighted fair turns.
+// Usage: bench_tenants [milliseconds]
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "hsm/executor.hpp"
+
+namespace {
+
+struct Event {
+	virtual ~Event() = default;
+};
+struct Request : Event {};
+
+struct Traits {
+	using StateID = int;
+	using Event   = ::Event;
+	struct Context {
+		std::uint64_t served = 0;
+	};
+};
+
+using Machine  = hsm::Machine<Traits>;
+using Scope    = hsm::Scope<Traits>;
+using Executor = hsm::Executor<Traits>;
+
+enum { SERVING };
+
+void build(Scope &s) {
+	s.state(SERVING).handle([](Machine &sm, const Event &) {
+		// Stand-in for per-request work
+		volatile std::uint64_t x = sm->served;
+		for (int i = 0; i < 500; ++i) { x = x * 6364136223846793005ull + 1; }
+		sm->served++;
+		return hsm::Result::Done;
+	});
+}
+
+double percentile(std::vector<double> &v, double p) {
+	if (v.empty()) { return 0; }
+	std::sort(v.begin(), v.end());
+	return v[static_cast<std::size_t>(p * (v.size() - 1))];
+}
+
+void run(const char *label, bool fair, long long millis) {
+	std::vector<std::unique_ptr<Machine>> fleet;
+	for (int i = 0; i < 9; ++i) {
+		fleet.emplace_back(new Machine());
+		fleet.back()->start(SERVING, build);
+	}
+
+	Executor          executor(1);
+	const std::size_t noisy_tenant = fair ? executor.add_tenant(1) : 0;
+	const std::size_t quiet_tenant = fair ? executor.add_tenant(1) : 0;
+	std::vector<Executor::Handle> noisy;
+	for (int i = 0; i < 8; ++i) { noisy.push_back(executor.add(*fleet[i], 0, noisy_tenant)); }
+	Executor::Handle quiet = executor.add(*fleet[8], 0, quiet_tenant);
+
+	std::atomic<bool> done{false};
+	std::thread       flood([&] {
+		bench::Rng                  rng(3);
+		std::deque<Machine::Ticket> window;
+		while (!done.load(std::memory_order_relaxed)) {
+			window.push_back(executor.post(noisy[rng.below(8)], Request{}));
+			if (window.size() > 4096) {
+				window.front().wait();
+				window.pop_front();
+			}
+		}
+		for (auto &t : window) { t.wait(); }
+	});
+
+	std::vector<double> latency;
+	bench::Stopwatch    clock;
+	while (clock.seconds() * 1000 < millis) {
+		bench::Stopwatch request;
+		executor.post(quiet, Request{}).wait();
+		latency.push_back(request.seconds() * 1e6);
+		std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+	done = true;
+	flood.join();
+
+	const double p50 = percentile(latency, 0.50);
+	const double p99 = percentile(latency, 0.99);
+	printf("%-8s quiet tenant: %6zu requests  p50 %10.1f us  p99 %10.1f us\n", label, latency.size(), p50, p99);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	const long long millis = argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 2000;
+
+	run("shared", false, millis);
+	run("fair", true, millis);
+}
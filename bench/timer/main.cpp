@@ -0,0 +1,87 @@
+// Wakeups and CPU time for fleet-wide keepalive timeouts, with and without timer slack.
+// Usage: bench_timer [machines] [seconds]
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "bench.hpp"
+#include "hsm/timer.hpp"
+
+namespace {
+
+struct Event {
+	virtual ~Event() = default;
+};
+struct Keepalive : Event {};
+
+struct Traits {
+	using StateID = int;
+	using Event   = ::Event;
+	struct Context {
+		std::uint64_t expired = 0;
+	};
+};
+
+using Machine = hsm::Machine<Traits>;
+using Scope   = hsm::Scope<Traits>;
+using Wheel   = hsm::TimerWheel;
+using ms      = std::chrono::milliseconds;
+
+enum { ALIVE };
+
+void build(Scope &s) {
+	s.state(ALIVE).handle([](Machine &sm, const Event &) {
+		sm->expired++;
+		return hsm::Result::Done;
+	});
+}
+
+struct Rearm {
+	Wheel            *wheel;
+	Machine          *sm;
+	Wheel::TimePoint *now;
+	ms                slack;
+
+	void operator()() const {
+		sm->dispatch(Keepalive{});
+		wheel->schedule(*now + ms(30000), *now + ms(30000) + slack, *this);
+	}
+};
+
+void run(const char *label, std::vector<hsm::Owned<Machine>> &fleet, long long seconds, ms slack) {
+	Wheel            wheel;
+	Wheel::TimePoint now;
+	bench::Rng       rng(7);
+	for (auto &sm : fleet) {
+		const Wheel::TimePoint armed = now + ms(rng.below(30000));
+		wheel.schedule(armed + ms(30000), armed + ms(30000) + slack, Rearm{&wheel, sm.get(), &now, slack});
+	}
+
+	bench::Stopwatch clock;
+	for (long long t = 0; t <= seconds * 1000; ++t) {
+		now = Wheel::TimePoint(ms(t));
+		if (wheel.next_wakeup() <= now) { wheel.advance(now); }
+	}
+	const double elapsed = clock.seconds();
+
+	printf("%-10s %10llu fired %8llu wakeups %8llu buckets %8.3f s CPU\n", label, static_cast<unsigned long long>(wheel.fired()),
+		   static_cast<unsigned long long>(wheel.wakeups()), static_cast<unsigned long long>(wheel.buckets_fired()), elapsed);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	const std::size_t machines = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+	const long long   seconds  = argc > 2 ? std::strtoll(argv[2], nullptr, 10) : 120;
+
+	std::vector<hsm::Owned<Machine>> fleet;
+	fleet.reserve(machines);
+	for (std::size_t i = 0; i < machines; ++i) {
+		fleet.push_back(hsm::make_owned<Machine>(*hsm::default_resource()));
+		fleet.back()->start(ALIVE, build);
+	}
+
+	run("exact", fleet, seconds, ms(0));
+	run("slack 1s", fleet, seconds, ms(1000));
+}
@@ -0,0 +1,155 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_BUFFER_HPP
+#define HSM_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "hsm.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// Shared Buffer
+// ============================================================================
+
+/// @brief Counted reference to an immutable byte range, for events that view received data instead of copying it
+/// @note Copying a reference, e.g. when an event carrying it is queued or posted, only bumps a count; the bytes are
+///       released once the last reference goes, which for queued events is right after their run-to-completion step.
+///       Counts are atomic, so references may cross threads.
+class BufferRef {
+public:
+	using Release = void (*)(void *context, const std::uint8_t *data);
+
+	BufferRef() = default;
+	BufferRef(const BufferRef &other) : block_(other.block_), data_(other.data_), size_(other.size_) { retain(); }
+	BufferRef(BufferRef &&other) : block_(other.block_), data_(other.data_), size_(other.size_) { other.block_ = nullptr; }
+	BufferRef &operator=(const BufferRef &other) {
+		BufferRef copy(other);
+		swap(copy);
+		return *this;
+	}
+	BufferRef &operator=(BufferRef &&other) {
+		BufferRef moved(std::move(other));
+		swap(moved);
+		return *this;
+	}
+	~BufferRef() { drop(); }
+
+	/// @brief Allocate `size` writable bytes from `resource`
+	/// @note Fill them through `mutable_data()` before sharing the reference. `resource` must tolerate being freed
+	///       from whichever thread drops the last reference.
+	static BufferRef allocate(std::size_t size, MemoryResource &resource = *default_resource()) {
+		void  *p = resource.allocate(sizeof(Block) + size, alignof(Block));
+		Block *b = new (p) Block();
+		b->bytes    = sizeof(Block) + size;
+		b->resource = &resource;
+		return BufferRef(b, reinterpret_cast<std::uint8_t *>(b + 1), size);
+	}
+
+	/// @brief Lease externally owned bytes, e.g. a slot of a receive ring
+	/// @param release Called once with `context` and `data` when the last reference is dropped
+	static BufferRef adopt(const void *data, std::size_t size, Release release, void *context) {
+		void  *p = default_resource()->allocate(sizeof(Block), alignof(Block));
+		Block *b = new (p) Block();
+		b->bytes    = sizeof(Block);
+		b->resource = default_resource();
+		b->release  = release;
+		b->context  = context;
+		b->external = static_cast<const std::uint8_t *>(data);
+		return BufferRef(b, b->external, size);
+	}
+
+	const std::uint8_t *data() const { return data_; }
+	std::size_t         size() const { return block_ ? size_ : 0; }
+	bool                empty() const { return size() == 0; }
+
+	explicit operator bool() const { return block_ != nullptr; }
+
+	/// @brief Writable access to an allocated buffer no one else references yet
+	/// @throws std::logic_error If the reference is shared or views adopted bytes
+	std::uint8_t *mutable_data() {
+		if (!block_ || block_->external || use_count() != 1) { throw std::logic_error("Buffer is shared or not owned"); }
+		return const_cast<std::uint8_t *>(data_);
+	}
+
+	/// @brief Reference to `size` bytes starting at `offset`, sharing the same lease
+	/// @throws std::out_of_range If the range exceeds this view
+	BufferRef slice(std::size_t offset, std::size_t size) const {
+		if (offset > size_ || size > size_ - offset) { throw std::out_of_range("Buffer slice out of range"); }
+		BufferRef r(*this);
+		r.data_ += offset;
+		r.size_ = size;
+		return r;
+	}
+
+	/// @brief References sharing this lease, including this one
+	std::uint32_t use_count() const { return block_ ? block_->refs.load(std::memory_order_acquire) : 0; }
+
+	void swap(BufferRef &other) {
+		std::swap(block_, other.block_);
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+	}
+
+private:
+	struct Block {
+		std::atomic<std::uint32_t> refs{1};
+		std::size_t                bytes    = 0;
+		MemoryResource            *resource = nullptr;
+		Release                    release  = nullptr;
+		void                      *context  = nullptr;
+		const std::uint8_t        *external = nullptr;
+	};
+
+	Block              *block_ = nullptr;
+	const std::uint8_t *data_  = nullptr;
+	std::size_t         size_  = 0;
+
+	BufferRef(Block *block, const std::uint8_t *data, std::size_t size) : block_(block), data_(data), size_(size) {}
+
+	void retain() {
+		if (block_) { block_->refs.fetch_add(1, std::memory_order_relaxed); }
+	}
+
+	void drop() {
+		if (!block_ || block_->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) { return; }
+		if (block_->release) { block_->release(block_->context, block_->external); }
+		MemoryResource   *resource = block_->resource;
+		const std::size_t bytes    = block_->bytes;
+		block_->~Block();
+		resource->deallocate(block_, bytes, alignof(Block));
+		block_ = nullptr;
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_BUFFER_HPP
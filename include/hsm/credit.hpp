@@ -0,0 +1,139 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_CREDIT_HPP
+#define HSM_CREDIT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+
+#include "executor.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// CreditLink
+// ============================================================================
+
+/// @brief Credit-based flow control from one producer to a consumer machine, without dropping events
+/// @note The link starts with a fixed number of credits. `send()` spends one per event it posts to the consumer,
+///       and the consumer hands it back as soon as that event's step finishes. With no credit left `send()`
+///       posts nothing and returns false. The producer should then pause, for example by moving to a state
+///       that holds its input. `grant` runs once credit is back, so memory stays bounded by `credits` events
+///       in the consumer's inbox and nobody polls. One thread sends at a time. A consumer driven by an
+///       `Executor` is linked through its handle so that sends also wake its shard. The consumer's `admission()`
+///       never sheds link posts, since the credits already bound them. The consumer's thread returns each credit
+///       through the link, so the link must outlive every event in flight: destroy it after the consumer's
+///       executor, or once `in_flight()` is zero and no drain is running.
+template <typename Traits>
+class CreditLink {
+public:
+	/// @brief Told that credit is available again after a refused `send()`; typically posts a resume event to
+	///        the producer. Runs on the thread returning the credit, normally the consumer's owner inside `drain()`.
+	using Grant = std::function<void()>;
+
+	/// @param consumer Started machine receiving the events; must outlive the link's events in flight
+	/// @param credits Maximum events posted through the link and not yet run
+	/// @param grant Callback run after a refused `send()` once a credit has been returned
+	/// @throws std::invalid_argument If `credits` is zero
+	CreditLink(Machine<Traits> &consumer, std::size_t credits, Grant grant)
+		: consumer_(&consumer), capacity_(credits), credits_(credits), grant_(std::move(grant)) {
+		if (credits == 0) { throw std::invalid_argument("CreditLink needs at least one credit"); }
+	}
+
+	/// @brief Link to a consumer registered with `executor`
+	/// @throws std::invalid_argument If `credits` is zero
+	CreditLink(Executor<Traits> &executor, typename Executor<Traits>::Handle consumer, std::size_t credits, Grant grant)
+		: CreditLink(executor.machine(consumer), credits, std::move(grant)) {
+		executor_ = &executor;
+		handle_   = consumer;
+	}
+
+	CreditLink(const CreditLink &)            = delete;
+	CreditLink &operator=(const CreditLink &) = delete;
+
+	/// @brief Post `evt` to the consumer if a credit is available
+	/// @return False, with nothing posted, when the producer must pause until `grant` runs
+	/// @throws std::invalid_argument If the consumer accepts no `E` (`Scope::accepts`); the credit is kept and
+	///         the producer still owns the event
+	template <typename E>
+	bool send(const E &evt) {
+		std::size_t c = credits_.load(std::memory_order_relaxed);
+		for (;;) {
+			if (c == 0) {
+				// Announce the wait before the final check so a credit returned in between is not missed
+				waiting_.store(true, std::memory_order_seq_cst);
+				c = credits_.load(std::memory_order_seq_cst);
+				if (c == 0) { return false; }
+				waiting_.store(false, std::memory_order_relaxed);
+			}
+			if (credits_.compare_exchange_weak(c, c - 1, std::memory_order_acq_rel)) { break; }
+		}
+		typename Machine<Traits>::Ticket ticket;
+		try {
+			if (executor_) {
+				ticket = executor_->post(handle_, evt, &CreditLink::refund, this);
+			} else {
+				ticket = consumer_->post(evt, &CreditLink::refund, this);
+			}
+		} catch (...) {
+			refund(this);
+			throw;
+		}
+		// A refused post already ran `refund`
+		if (ticket.refused()) { throw std::invalid_argument("Consumer does not accept this event type"); }
+		return true;
+	}
+
+	/// @brief Credits left for the producer
+	std::size_t credits() const { return credits_.load(std::memory_order_relaxed); }
+
+	/// @brief Events posted through the link that have not run yet
+	std::size_t in_flight() const { return capacity_ - credits(); }
+
+	/// @brief Whether the last `send()` was refused and `grant` has not run since
+	bool blocked() const { return waiting_.load(std::memory_order_relaxed); }
+
+private:
+	Machine<Traits>                  *consumer_;
+	Executor<Traits>                 *executor_ = nullptr;
+	typename Executor<Traits>::Handle handle_   = nullptr;
+	std::size_t                       capacity_;
+	std::atomic<std::size_t>          credits_;
+	std::atomic<bool>                 waiting_{false};  // A refused `send()` awaits `grant_`
+	Grant                             grant_;
+
+	static void refund(void *ctx) {
+		auto *self = static_cast<CreditLink *>(ctx);
+		self->credits_.fetch_add(1, std::memory_order_seq_cst);
+		if (self->waiting_.exchange(false, std::memory_order_seq_cst) && self->grant_) { self->grant_(); }
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_CREDIT_HPP
@@ -0,0 +1,442 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_EXECUTOR_HPP
+#define HSM_EXECUTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "hsm.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// Executor
+// ============================================================================
+
+/// @brief Thread-per-shard driver for started machines, moving machines off hot shards
+/// @note Events reach a machine through `post()`, which routes to whichever shard currently owns it. A machine
+///       changes shard only between two `drain()` calls of its owner, so handlers never run on two threads at once.
+///       Timers armed on any thread should fire through `post()` and follow the machine without hand-over.
+///       Within a shard, tenants share capacity by deficit round robin: each turn a tenant may run up to
+///       `quantum` events per unit of weight, so a flooding tenant cannot starve the others.
+///       With `admission()` set, each post is predicted to wait for the shard's recent queueing delay plus the
+///       machine's own backlog, and is shed up front when that exceeds the SLO.
+///       With `lookahead()` set, a worker prefetches the machines queued behind the one it is draining, which
+///       hides cache misses on fleets much larger than the last-level cache.
+template <typename Traits>
+class Executor {
+	struct Slot;
+
+public:
+	/// @brief Registered machine
+	using Handle = Slot *;
+
+	enum : std::size_t { quantum = 8 };  // Events per unit of tenant weight and scheduling turn
+
+	/// @param shards Number of worker threads
+	/// @param rebalance_period Interval of the built-in load monitor; zero leaves rebalancing to `rebalance()`
+	/// @throws std::invalid_argument If `shards` is zero
+	explicit Executor(std::size_t shards, std::chrono::milliseconds rebalance_period = std::chrono::milliseconds::zero())
+		: period_(rebalance_period) {
+		if (shards == 0) { throw std::invalid_argument("Executor needs at least one shard"); }
+		weights_.emplace_back(1);
+		for (std::size_t i = 0; i < shards; ++i) { shards_.push_back(std::unique_ptr<Shard>(new Shard())); }
+		for (std::size_t i = 0; i < shards; ++i) { shards_[i]->thread = std::thread([this, i] { run(i); }); }
+		if (period_ > std::chrono::milliseconds::zero()) { monitor_ = std::thread([this] { watch(); }); }
+	}
+
+	/// @brief Stop the workers once no shard has anything queued
+	/// @note Posts made by handlers while draining, including those to machines on other shards, still run.
+	///       Other threads must have stopped posting.
+	~Executor() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		idle_.notify_all();
+		if (monitor_.joinable()) { monitor_.join(); }
+		closing_.store(true, std::memory_order_seq_cst);
+		wake_all();
+		for (auto &s : shards_) { s->thread.join(); }
+	}
+
+	Executor(const Executor &)            = delete;
+	Executor &operator=(const Executor &) = delete;
+
+	/// @brief Register a tenant sharing shards with the others in proportion to `weight`
+	/// @return Tenant index for `add()`; tenant 0 exists from the start with weight 1
+	/// @throws std::invalid_argument If `weight` is zero
+	std::size_t add_tenant(std::uint32_t weight) {
+		if (weight == 0) { throw std::invalid_argument("Tenant weight must be positive"); }
+		std::lock_guard<std::mutex> lock(mutex_);
+		weights_.emplace_back(weight);
+		return weights_.size() - 1;
+	}
+
+	/// @brief Change a tenant's share; takes effect from its next turn
+	/// @throws std::invalid_argument If the tenant is unknown or `weight` is zero
+	void set_weight(std::size_t tenant, std::uint32_t weight) {
+		if (weight == 0) { throw std::invalid_argument("Tenant weight must be positive"); }
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (tenant >= weights_.size()) { throw std::invalid_argument("Unknown tenant"); }
+		weights_[tenant].store(weight, std::memory_order_relaxed);
+	}
+
+	/// @brief Hand a started machine to the executor
+	/// @param sm Machine that must outlive the executor and is no longer driven by the caller
+	/// @param shard Initial owner
+	/// @param tenant Tenant from `add_tenant()` whose share the machine draws on
+	/// @throws std::invalid_argument If `shard` or `tenant` is out of range
+	/// @note A machine that already has `admission()` set keeps its own settings, as after `admission(h, ...)`
+	Handle add(Machine<Traits> &sm, std::size_t shard, std::size_t tenant = 0) {
+		if (shard >= shards_.size()) { throw std::invalid_argument("Shard index out of range"); }
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (tenant >= weights_.size()) { throw std::invalid_argument("Unknown tenant"); }
+		const bool own = sm.admission_slo().count() > 0;
+		if (!own && slo_.count() > 0) { sm.admission(slo_, shed_); }
+		std::unique_ptr<Slot> slot(new Slot(sm, static_cast<std::uint32_t>(shard), static_cast<std::uint32_t>(tenant), weights_[tenant]));
+		slot->own_admission = own;
+		slots_.push_back(std::move(slot));
+		return slots_.back().get();
+	}
+
+	/// @brief Post an event to a registered machine from any thread
+	/// @note Shed posts resolve unhandled at once and do not wake the shard
+	template <typename E>
+	typename Machine<Traits>::Ticket post(Handle h, const E &evt) {
+		return post(h, evt, nullptr, nullptr);
+	}
+
+	/// @brief Post with a completion hook, as `Machine::post(evt, done, ctx)`
+	template <typename E>
+	typename Machine<Traits>::Ticket post(Handle h, const E &evt, typename Machine<Traits>::Done done, void *ctx) {
+		auto ticket = h->sm->post(evt, done, ctx, delay(*shards_[h->shard.load(std::memory_order_acquire)]));
+		if (!ticket.ready()) { schedule(h); }
+		return ticket;
+	}
+
+	/// @brief Apply `Machine::admission()` to every registered machine and to those added later
+	/// @param slo Bound on shard queueing plus mailbox and service time; zero turns admission control off
+	/// @param shed Optional callback for refused posts, run on the posting thread
+	/// @note Machines with settings of their own, from `admission(h, ...)` or set before `add()`, are left alone
+	void admission(std::chrono::nanoseconds slo, typename Machine<Traits>::Shed shed = nullptr) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		slo_  = slo;
+		shed_ = std::move(shed);
+		for (auto &s : slots_) {
+			if (!s->own_admission) { s->sm->admission(slo_, shed_); }
+		}
+	}
+
+	/// @brief Give one registered machine its own admission settings, which executor-wide calls no longer change
+	void admission(Handle h, std::chrono::nanoseconds slo, typename Machine<Traits>::Shed shed = nullptr) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		h->own_admission = true;
+		h->sm->admission(slo, std::move(shed));
+	}
+
+	/// @brief Prefetch up to `depth` queued machines ahead of the one being drained; zero turns it off
+	/// @note Each queued machine is pipelined in three steps: its registration at twice the distance, the
+	///       machine object at `depth`, and the state, context and inbox it points to just before it runs
+	void lookahead(std::size_t depth) { lookahead_.store(depth, std::memory_order_relaxed); }
+
+	/// @brief Recent time machines on `shard` waited in its ready queue before they ran
+	std::chrono::nanoseconds queue_delay(std::size_t shard) const { return std::chrono::nanoseconds(shards_.at(shard)->delay.load(std::memory_order_relaxed)); }
+
+	/// @brief Ask the owner of `h` to pass it to `shard` at its next quiescent point
+	/// @throws std::invalid_argument If `shard` is out of range
+	void migrate(Handle h, std::size_t shard) {
+		if (shard >= shards_.size()) { throw std::invalid_argument("Shard index out of range"); }
+		h->move_to.store(static_cast<std::int32_t>(shard), std::memory_order_relaxed);
+		schedule(h);
+	}
+
+	/// @brief Machine registered as `h`
+	Machine<Traits> &machine(Handle h) const { return *h->sm; }
+
+	/// @brief Shard currently owning `h`
+	std::size_t shard_of(Handle h) const { return h->shard.load(std::memory_order_acquire); }
+
+	std::size_t shards() const { return shards_.size(); }
+
+	/// @brief Machines moved between shards so far
+	std::uint64_t migrations() const { return migrations_.load(std::memory_order_relaxed); }
+
+	/// @brief Events whose handler threw; each one's ticket resolved unhandled and its worker carried on
+	std::uint64_t failures() const { return failures_.load(std::memory_order_relaxed); }
+
+	/// @brief Compare shard load since the previous call and move machines from the busiest shard to the idlest
+	/// @param tolerance Allowed ratio between the busiest and idlest shard before anything moves
+	/// @return Number of migrations requested
+	/// @note Load is counted in drained events; per-machine counts pick which machines move
+	std::size_t rebalance(double tolerance = 1.25) {
+		std::vector<std::uint64_t> load(shards_.size());
+		for (std::size_t i = 0; i < shards_.size(); ++i) { load[i] = shards_[i]->events.exchange(0, std::memory_order_relaxed); }
+		const auto hot  = static_cast<std::size_t>(std::max_element(load.begin(), load.end()) - load.begin());
+		const auto cold = static_cast<std::size_t>(std::min_element(load.begin(), load.end()) - load.begin());
+
+		std::vector<std::pair<std::uint64_t, Slot *>> candidates;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (auto &s : slots_) {
+				const std::uint64_t n = s->load.exchange(0, std::memory_order_relaxed);
+				if (s->shard.load(std::memory_order_relaxed) == hot && n) { candidates.emplace_back(n, s.get()); }
+			}
+		}
+		if (hot == cold || double(load[hot]) <= double(load[cold]) * tolerance || candidates.size() < 2) { return 0; }
+
+		// The busiest machine stays; the next ones move without overshooting half the gap
+		std::sort(candidates.begin(), candidates.end(), [](const std::pair<std::uint64_t, Slot *> &a, const std::pair<std::uint64_t, Slot *> &b) {
+			return a.first > b.first;
+		});
+		const std::uint64_t budget = (load[hot] - load[cold]) / 2;
+		std::uint64_t       moved  = 0;
+		std::size_t         count  = 0;
+		for (std::size_t i = 1; i < candidates.size(); ++i) {
+			if (moved + candidates[i].first > budget) { continue; }
+			moved += candidates[i].first;
+			migrate(candidates[i].second, cold);
+			++count;
+		}
+		return count;
+	}
+
+private:
+	struct Slot {
+		Machine<Traits>                  *sm;
+		std::uint32_t                     tenant;
+		const std::atomic<std::uint32_t> *weight;  // Shared by the tenant's machines
+		std::atomic<std::uint32_t>        shard;
+		std::atomic<std::int32_t>         move_to{-1};
+		std::atomic<bool>                 queued{false};
+		std::atomic<std::int64_t>         queued_at{0};  // `steady_ns()` when `queued` last became true
+		std::atomic<std::uint64_t>        load{0};       // Events drained since the last `rebalance()`
+		bool                              own_admission = false;  // Guarded by `mutex_`
+
+		Slot(Machine<Traits> &sm, std::uint32_t shard, std::uint32_t tenant, const std::atomic<std::uint32_t> &weight)
+			: sm(&sm), tenant(tenant), weight(&weight), shard(shard) {}
+	};
+
+	struct Shard {
+		std::mutex                 mutex;
+		std::condition_variable    wake;
+		std::vector<Slot *>        ready;
+		std::atomic<std::uint64_t> events{0};   // Events drained since the last `rebalance()`
+		std::atomic<std::int64_t>  delay{0};    // Moving average of ns between queueing and draining a machine
+		std::atomic<std::size_t>   waiting{0};  // Machines queued on this shard and not yet drained
+		std::thread                thread;
+	};
+
+	// Per-shard, per-tenant scheduling state, touched by the shard's worker only
+	struct Flow {
+		std::deque<Slot *> ready;
+		std::size_t        deficit = 0;
+		bool               active  = false;
+	};
+
+	std::vector<std::unique_ptr<Shard>>    shards_;
+	std::vector<std::unique_ptr<Slot>>     slots_;
+	std::deque<std::atomic<std::uint32_t>> weights_;  // Per tenant; elements never move
+	std::mutex                             mutex_;    // Guards `slots_`, `weights_` growth and `stopping_`
+	std::condition_variable                idle_;
+	bool                                   stopping_ = false;
+	std::chrono::milliseconds              period_;
+	std::thread                            monitor_;
+	std::atomic<std::uint64_t>             migrations_{0};
+	std::atomic<std::uint64_t>             failures_{0};
+	std::atomic<std::size_t>               outstanding_{0};  // Slots queued on some shard or being drained
+	std::atomic<bool>                      closing_{false};  // Workers exit once `outstanding_` reaches zero
+	std::atomic<std::size_t>               lookahead_{0};
+	std::chrono::nanoseconds               slo_{0};  // Admission settings for `add()`, guarded by `mutex_`
+	typename Machine<Traits>::Shed         shed_;
+
+	// Queue `h` on its owner unless it is already queued somewhere
+	void schedule(Slot *h) {
+		if (h->queued.exchange(true, std::memory_order_acq_rel)) { return; }
+		outstanding_.fetch_add(1, std::memory_order_relaxed);
+		h->queued_at.store(detail::steady_ns(), std::memory_order_relaxed);
+		enqueue(*shards_[h->shard.load(std::memory_order_acquire)], h);
+	}
+
+	// Predicted wait before a post to a machine on `s` gets drained; an idle shard has none
+	static std::chrono::nanoseconds delay(const Shard &s) {
+		if (s.waiting.load(std::memory_order_relaxed) == 0) { return std::chrono::nanoseconds::zero(); }
+		return std::chrono::nanoseconds(s.delay.load(std::memory_order_relaxed));
+	}
+
+	static void enqueue(Shard &s, Slot *h) {
+		s.waiting.fetch_add(1, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			s.ready.push_back(h);
+		}
+		s.wake.notify_one();
+	}
+
+	// Wake every worker so it rechecks whether the executor is closing with nothing left to run
+	void wake_all() {
+		for (auto &s : shards_) {
+			{
+				std::lock_guard<std::mutex> lock(s->mutex);
+			}
+			s->wake.notify_all();
+		}
+	}
+
+	// A slot left its queue without going back; the last one out during shutdown releases the workers
+	void settled() {
+		if (outstanding_.fetch_sub(1, std::memory_order_seq_cst) == 1 && closing_.load(std::memory_order_seq_cst)) { wake_all(); }
+	}
+
+	void run(std::size_t self) {
+		Shard                    &shard = *shards_[self];
+		std::vector<Slot *>       batch;
+		std::vector<Flow>         flows;
+		std::deque<std::uint32_t> active;
+		const auto                finished = [this] {
+			return closing_.load(std::memory_order_seq_cst) && outstanding_.load(std::memory_order_seq_cst) == 0;
+		};
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(shard.mutex);
+				if (active.empty()) { shard.wake.wait(lock, [&] { return !shard.ready.empty() || finished(); }); }
+				if (shard.ready.empty() && active.empty()) { return; }
+				batch.swap(shard.ready);
+			}
+			for (Slot *h : batch) {
+				const std::uint32_t owner = h->shard.load(std::memory_order_acquire);
+				if (owner != self) {
+					// Migrated after it was queued here; it stays outstanding while it moves
+					enqueue(*shards_[owner], h);
+					shard.waiting.fetch_sub(1, std::memory_order_relaxed);
+					continue;
+				}
+				if (h->tenant >= flows.size()) { flows.resize(h->tenant + 1); }
+				Flow &f = flows[h->tenant];
+				f.ready.push_back(h);
+				if (!f.active) {
+					f.active = true;
+					active.push_back(h->tenant);
+				}
+			}
+			batch.clear();
+			if (!active.empty()) { serve(self, flows, active); }
+		}
+	}
+
+	// Give the tenant at the front of the round one turn, then requeue it if it still has work
+	void serve(std::size_t self, std::vector<Flow> &flows, std::deque<std::uint32_t> &active) {
+		const std::uint32_t tenant = active.front();
+		active.pop_front();
+		Flow &f = flows[tenant];
+		f.deficit += quantum * f.ready.front()->weight->load(std::memory_order_relaxed);
+
+		Shard            &shard = *shards_[self];
+		const std::size_t depth = lookahead_.load(std::memory_order_relaxed);
+		while (!f.ready.empty() && f.deficit > 0) {
+			if (depth) { prefetch(f.ready, depth); }
+			Slot *h = f.ready.front();
+			f.ready.pop_front();
+			shard.waiting.fetch_sub(1, std::memory_order_relaxed);
+			const std::int64_t sojourn = detail::steady_ns() - h->queued_at.load(std::memory_order_relaxed);
+			const std::int64_t average = shard.delay.load(std::memory_order_relaxed);
+			shard.delay.store(average + (sojourn - average) / 8, std::memory_order_relaxed);
+			h->queued.store(false, std::memory_order_release);
+			// Only the events actually resolved are charged. A drain that threw may still hold posts, so its
+			// machine is requeued like one that used up its budget, while the tenant keeps what is left.
+			const std::size_t limit  = f.deficit;
+			std::size_t       n      = 0;
+			bool              failed = false;
+			try {
+				h->sm->drain(limit, n);
+			} catch (...) {
+				// `drain()` resolved the failed event's ticket; the rest of its batch runs on a later turn
+				failures_.fetch_add(1, std::memory_order_relaxed);
+				failed = true;
+			}
+			f.deficit -= n;
+			h->load.fetch_add(n, std::memory_order_relaxed);
+			shard.events.fetch_add(n, std::memory_order_relaxed);
+			const bool more = n == limit || failed;
+
+			const std::int32_t target = h->move_to.exchange(-1, std::memory_order_relaxed);
+			if (target >= 0 && std::size_t(target) != self) {
+				h->shard.store(static_cast<std::uint32_t>(target), std::memory_order_release);
+				migrations_.fetch_add(1, std::memory_order_relaxed);
+				if (more && !h->queued.exchange(true, std::memory_order_acq_rel)) {
+					outstanding_.fetch_add(1, std::memory_order_relaxed);
+					h->queued_at.store(detail::steady_ns(), std::memory_order_relaxed);
+					enqueue(*shards_[target], h);
+				}
+			} else if (more && !h->queued.exchange(true, std::memory_order_acq_rel)) {
+				// Ran out of budget, or failed, with events possibly left
+				outstanding_.fetch_add(1, std::memory_order_relaxed);
+				h->queued_at.store(detail::steady_ns(), std::memory_order_relaxed);
+				shard.waiting.fetch_add(1, std::memory_order_relaxed);
+				f.ready.push_back(h);
+			}
+			settled();
+		}
+
+		if (f.ready.empty()) {
+			f.deficit = 0;
+			f.active  = false;
+		} else {
+			active.push_back(tenant);
+		}
+	}
+
+	// Pipeline cache misses for the machines queued behind the front of `ready`
+	static void prefetch(const std::deque<Slot *> &ready, std::size_t depth) {
+		const std::size_t n = ready.size();
+		if (2 * depth < n) { detail::prefetch(ready[2 * depth]); }
+		if (depth < n) { ready[depth]->sm->prefetch(false); }
+		if (1 < n) { ready[1]->sm->prefetch(true); }
+	}
+
+	void watch() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (!idle_.wait_for(lock, period_, [this] { return stopping_; })) {
+			lock.unlock();
+			rebalance();
+			lock.lock();
+		}
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_EXECUTOR_HPP
@@ -27,11 +27,21 @@
 #define HSM_HSM_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <initializer_list>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <typeinfo>
 #include <utility>
@@ -49,6 +59,354 @@ class Machine;
 template <typename Traits>
 class Scope;
 
+/// @brief `Traits::ContextStorage` tag: the machine embeds its context by value (default)
+struct InlineContext {};
+
+/// @brief `Traits::ContextStorage` tag: the machine refers to a context owned elsewhere, e.g. a row in a fleet arena
+/// @note Such machines are constructed from a `Context &`, which must outlive them or be replaced with `rebind_context`
+struct ExternalContext {};
+
+/// @brief Counters describing events the machine refused before running any handler
+struct Stats {
+	std::uint64_t rate_limited = 0;  // Rejected by a token bucket declared with `Scope::limit`
+	std::uint64_t unhandleable = 0;  // Dropped because no state that could run accepts the type (`Scope::accepts`)
+	std::uint64_t shed         = 0;  // Posts refused because their predicted delay exceeded the admission SLO
+};
+
+/// @brief Interned state: the dense index `Machine::intern()` resolved from a `StateID`, so hot paths never
+///        compare IDs. Valid until the state is removed or the machine is started again.
+struct StateRef {
+	std::uint32_t index;
+
+	explicit StateRef(std::uint32_t index = 0) : index(index) {}
+
+	bool operator==(const StateRef &other) const { return index == other.index; }
+	bool operator!=(const StateRef &other) const { return index != other.index; }
+};
+
+namespace detail {
+
+template <typename...>
+struct make_void {
+	typedef void type;
+};
+
+template <typename Traits, typename = void>
+struct context_storage {
+	using type = InlineContext;
+};
+
+template <typename Traits>
+struct context_storage<Traits, typename make_void<typename Traits::ContextStorage>::type> {
+	using type = typename Traits::ContextStorage;
+};
+
+template <typename Traits, typename = void>
+struct concurrent_queries : std::false_type {};
+
+template <typename Traits>
+struct concurrent_queries<Traits, typename make_void<decltype(Traits::ConcurrentQueries)>::type>
+	: std::integral_constant<bool, Traits::ConcurrentQueries> {};
+
+template <typename Context, typename Storage>
+class ContextHolder;
+
+template <typename Context>
+class ContextHolder<Context, InlineContext> {
+	Context ctx_;
+
+public:
+	template <typename... Args>
+	explicit ContextHolder(Args &&...args) : ctx_(std::forward<Args>(args)...) {}
+
+	Context       *get() { return &ctx_; }
+	const Context *get() const { return &ctx_; }
+};
+
+template <typename Context>
+class ContextHolder<Context, ExternalContext> {
+	Context *ctx_;
+
+public:
+	explicit ContextHolder(Context &ctx) : ctx_(&ctx) {}
+
+	Context       *get() { return ctx_; }
+	const Context *get() const { return ctx_; }
+	void           rebind(Context &ctx) { ctx_ = &ctx; }
+};
+
+inline std::size_t next_type_index() {
+	static std::atomic<std::size_t> counter{0};
+	return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Dense per-type index, assigned on first use and stable for the process lifetime
+template <typename T>
+std::size_t type_index() {
+	static const std::size_t index = next_type_index();
+	return index;
+}
+
+}  // namespace detail
+
+/// @brief Per-thread record of the action currently running, written by the machine and read by a monitor
+/// @note `seq` is odd while an action runs; the other fields describe that action
+struct WatchSlot {
+	std::atomic<std::uint64_t> seq{0};
+	std::atomic<const char *>  state{nullptr};
+	std::atomic<const char *>  action{nullptr};
+	std::atomic<const char *>  event{nullptr};
+	std::atomic<std::int64_t>  since{0};  // steady_clock nanoseconds
+};
+
+namespace detail {
+
+// Slot published by the calling thread, or null when no monitor is attached
+inline WatchSlot *&watch_slot() {
+	static thread_local WatchSlot *slot = nullptr;
+	return slot;
+}
+
+inline std::int64_t steady_ns() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Hint that the cache line holding `p` is read soon; a no-op where the compiler has no builtin
+inline void prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(p, 0, 3);
+#else
+	(void)p;
+#endif
+}
+
+// Marks one action as running in `slot` for its lifetime, restoring an enclosing action on exit; only built
+// while a watchdog is attached to the thread, so unwatched machines never construct one
+class WatchGuard {
+	WatchSlot   *slot_;
+	const char  *state_  = nullptr;
+	const char  *action_ = nullptr;
+	const char  *event_  = nullptr;
+	std::int64_t since_  = 0;
+	bool         nested_ = false;
+
+	static void publish(WatchSlot *slot, const char *state, const char *action, const char *event, std::int64_t since) {
+		std::atomic_thread_fence(std::memory_order_release);
+		slot->state.store(state, std::memory_order_relaxed);
+		slot->action.store(action, std::memory_order_relaxed);
+		slot->event.store(event, std::memory_order_relaxed);
+		slot->since.store(since, std::memory_order_relaxed);
+		slot->seq.fetch_add(1, std::memory_order_release);
+	}
+
+public:
+	template <typename S>
+	WatchGuard(WatchSlot *slot, const S *s, const char *action, const char *event) : slot_(slot) {
+		if (slot_->seq.load(std::memory_order_relaxed) & 1) {
+			nested_ = true;
+			state_  = slot_->state.load(std::memory_order_relaxed);
+			action_ = slot_->action.load(std::memory_order_relaxed);
+			event_  = slot_->event.load(std::memory_order_relaxed);
+			since_  = slot_->since.load(std::memory_order_relaxed);
+			slot_->seq.fetch_add(1, std::memory_order_release);
+		}
+		publish(slot_, s->name(), action, event, steady_ns());
+	}
+
+	~WatchGuard() {
+		slot_->seq.fetch_add(1, std::memory_order_release);
+		if (nested_) { publish(slot_, state_, action_, event_, since_); }
+	}
+
+	WatchGuard(const WatchGuard &)            = delete;
+	WatchGuard &operator=(const WatchGuard &) = delete;
+};
+
+}  // namespace detail
+
+// ============================================================================
+// Memory Resources
+// ============================================================================
+
+/// @brief Allocation backend for state objects, queued events and machine bookkeeping
+class MemoryResource {
+public:
+	virtual ~MemoryResource() = default;
+
+	virtual void *allocate(std::size_t bytes, std::size_t align) = 0;
+	virtual void  deallocate(void *p, std::size_t bytes, std::size_t align) = 0;
+};
+
+/// @brief Resource forwarding to global `operator new`/`operator delete`
+/// @note Alignments above `alignof(std::max_align_t)` over-allocate and keep the original pointer just below the block
+class NewDeleteResource : public MemoryResource {
+public:
+	void *allocate(std::size_t bytes, std::size_t align) override {
+		if (align <= alignof(std::max_align_t)) { return ::operator new(bytes); }
+		void               *raw = ::operator new(bytes + align + sizeof(void *));
+		const std::uintptr_t at  = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void *) + align - 1) & ~(std::uintptr_t(align) - 1);
+		reinterpret_cast<void **>(at)[-1] = raw;
+		return reinterpret_cast<void *>(at);
+	}
+	void deallocate(void *p, std::size_t, std::size_t align) override {
+		if (p && align > alignof(std::max_align_t)) { p = static_cast<void **>(p)[-1]; }
+		::operator delete(p);
+	}
+};
+
+/// @brief Resource used by machines that were not given one
+inline MemoryResource *default_resource() {
+	static NewDeleteResource resource;
+	return &resource;
+}
+
+/// @brief Size-class pool carving blocks out of large chunks supplied by a derived class
+/// @note Freed blocks are recycled per size class; chunks are returned only when the derived resource is destroyed
+class PoolResource : public MemoryResource {
+public:
+	enum : std::size_t {
+		alignment = 16,         // Alignment of every pooled block
+		max_block = 64 * 1024,  // Larger requests go to `default_resource()`
+	};
+
+	void *allocate(std::size_t bytes, std::size_t align) override {
+		if (bytes > max_block || align > alignment) { return default_resource()->allocate(bytes, align); }
+		const std::size_t cls = size_class(bytes);
+		if (FreeBlock *b = free_[cls]) {
+			free_[cls] = b->next;
+			return b;
+		}
+		const std::size_t size = class_size(cls);
+		if (static_cast<std::size_t>(end_ - cursor_) < size) {
+			std::size_t got = 0;
+			void       *chunk = refill(size, got);
+			if (!chunk) { throw std::bad_alloc(); }
+			cursor_ = static_cast<char *>(chunk);
+			end_    = cursor_ + got;
+		}
+		void *p = cursor_;
+		cursor_ += size;
+		return p;
+	}
+
+	void deallocate(void *p, std::size_t bytes, std::size_t align) override {
+		if (!p) { return; }
+		if (bytes > max_block || align > alignment) { return default_resource()->deallocate(p, bytes, align); }
+		const std::size_t cls = size_class(bytes);
+		auto             *b   = static_cast<FreeBlock *>(p);
+		b->next               = free_[cls];
+		free_[cls]            = b;
+	}
+
+protected:
+	/// @brief Provide a new chunk of at least `min_bytes`, aligned to `alignment`
+	/// @param got Receives the usable size of the chunk
+	/// @return The chunk, or null when the resource is exhausted
+	virtual void *refill(std::size_t min_bytes, std::size_t &got) = 0;
+
+	/// @brief Bytes left in the current chunk
+	std::size_t remaining() const { return static_cast<std::size_t>(end_ - cursor_); }
+
+private:
+	struct FreeBlock {
+		FreeBlock *next;
+	};
+
+	// 16-byte steps up to 256 bytes, then powers of two up to `max_block`
+	enum : std::size_t { fine_classes = 16, num_classes = fine_classes + 8 };
+
+	FreeBlock *free_[num_classes] = {};
+	char      *cursor_            = nullptr;
+	char      *end_               = nullptr;
+
+	static std::size_t size_class(std::size_t bytes) {
+		if (bytes <= fine_classes * alignment) { return bytes ? (bytes - 1) / alignment : 0; }
+		std::size_t cls = fine_classes, size = 2 * fine_classes * alignment;
+		while (size < bytes) {
+			size <<= 1;
+			++cls;
+		}
+		return cls;
+	}
+
+	static std::size_t class_size(std::size_t cls) {
+		if (cls < fine_classes) { return (cls + 1) * alignment; }
+		return (2 * fine_classes * alignment) << (cls - fine_classes);
+	}
+};
+
+/// @brief Constructor tag choosing a machine's `MemoryResource` before anything is allocated
+struct WithResource {
+	MemoryResource *resource;
+
+	explicit WithResource(MemoryResource &resource) : resource(&resource) {}
+};
+
+/// @brief Stateful standard allocator drawing from a `MemoryResource`
+template <typename T>
+class ResourceAllocator {
+	template <typename U>
+	friend class ResourceAllocator;
+
+	MemoryResource *resource_;
+
+public:
+	using value_type                             = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap            = std::true_type;
+
+	ResourceAllocator(MemoryResource *resource = default_resource()) : resource_(resource) {}
+	template <typename U>
+	ResourceAllocator(const ResourceAllocator<U> &other) : resource_(other.resource_) {}
+
+	T   *allocate(std::size_t n) { return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T *p, std::size_t n) { resource_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+	MemoryResource *resource() const { return resource_; }
+
+	template <typename U>
+	bool operator==(const ResourceAllocator<U> &other) const {
+		return resource_ == other.resource_;
+	}
+	template <typename U>
+	bool operator!=(const ResourceAllocator<U> &other) const {
+		return resource_ != other.resource_;
+	}
+};
+
+/// @brief Deleter returning an object created by `make_owned` to its resource
+struct ResourceDeleter {
+	MemoryResource *resource = nullptr;
+	std::uint32_t   size     = 0;
+	std::uint32_t   align    = 0;
+
+	ResourceDeleter() = default;
+	ResourceDeleter(MemoryResource *r, std::size_t s, std::size_t a)
+		: resource(r), size(static_cast<std::uint32_t>(s)), align(static_cast<std::uint32_t>(a)) {}
+
+	template <typename T>
+	void operator()(T *p) const {
+		p->~T();
+		resource->deallocate(p, size, align);
+	}
+};
+
+template <typename T>
+using Owned = std::unique_ptr<T, ResourceDeleter>;
+
+/// @brief Construct a `T` in memory obtained from `resource`
+template <typename T, typename... Args>
+Owned<T> make_owned(MemoryResource &resource, Args &&...args) {
+	void *p = resource.allocate(sizeof(T), alignof(T));
+	try {
+		return Owned<T>(new (p) T(std::forward<Args>(args)...), ResourceDeleter{&resource, sizeof(T), alignof(T)});
+	} catch (...) {
+		resource.deallocate(p, sizeof(T), alignof(T));
+		throw;
+	}
+}
+
 // ============================================================================
 // State Base Class
 // ============================================================================
@@ -66,17 +424,62 @@ public:
 	virtual ~State() = default;
 
 	virtual Result      handle(Machine<Traits> &, const Event &) { return Result::Pass; }
+	virtual Result      query(const Machine<Traits> &, const Event &) const { return Result::Pass; }
 	virtual void        on_entry(Machine<Traits> &) {}
 	virtual void        on_exit(Machine<Traits> &) {}
 	virtual const char *name() const { return "State"; }
 
 	StateID id() const { return id_; }
 
+	/// @brief Dense registration index within the machine; the root is 0
+	std::uint32_t index() const { return index_; }
+
+	/// @brief Enclosing state, or null for the root
+	const State<Traits> *parent() const { return parent_; }
+
 private:
+	// Ordered so that an integral `StateID` shares a word with the index and the flags fill the depth's word
 	StateID        id_        = StateID{};
-	std::size_t    depth_     = 0;
+	std::uint32_t  index_     = 0;  // Registration order within the machine
 	State<Traits> *parent_    = nullptr;
 	State<Traits> *path_next_ = nullptr;
+	std::uint32_t  depth_     = 0;
+	bool           declared_  = false;  // Transition targets were declared with `Scope::targets`
+	bool           completes_ = false;  // Has completion transitions declared with `Scope::completion`
+	bool           filters_   = false;  // Handled event types were declared with `Scope::accepts`
+	bool           open_      = false;  // Some state on the path from here to the root accepts every type
+
+	// Whether this state has any code that could request a transition
+	virtual bool may_transition() const { return true; }
+
+	// Whether this state has any code that could handle an event
+	virtual bool may_handle() const { return true; }
+};
+
+// ============================================================================
+// Observer
+// ============================================================================
+
+/// @brief Hook for recording what a machine does, registered with `Machine::observe`
+/// @note Callbacks run on the dispatching thread, inside the step; they must not dispatch to or edit the machine
+template <typename Traits>
+class Observer {
+public:
+	virtual ~Observer() = default;
+
+	/// @brief An event is about to run its step
+	/// @param type Dense per-process index of the event's static type, or `size_t(-1)` for the base `Event`
+	virtual void on_dispatch(const Machine<Traits> &, const typename Traits::Event &, std::size_t) {}
+
+	/// @brief A transition settled; `from` is the root when the machine starts
+	/// @note Not called for a transition during which the machine was stopped, e.g. from an entry action
+	virtual void on_transition(const Machine<Traits> &, const State<Traits> *, const State<Traits> *) {}
+
+	/// @brief A run-to-completion step finished, including the transitions it triggered
+	virtual void on_step(const Machine<Traits> &) {}
+
+	/// @brief `stop()` terminated the machine, from a handler or from outside a step
+	virtual void on_stop(const Machine<Traits> &) {}
 };
 
 // ============================================================================
@@ -90,6 +493,7 @@ class LambdaState : public State<Traits> {
 
 public:
 	using HandleFn = std::function<Result(Machine<Traits> &, const typename Traits::Event &)>;
+	using QueryFn  = std::function<Result(const Machine<Traits> &, const typename Traits::Event &)>;
 	using EntryFn  = std::function<void(Machine<Traits> &)>;
 	using ExitFn   = std::function<void(Machine<Traits> &)>;
 
@@ -97,210 +501,1502 @@ public:
 	LambdaState(const char *name) : name_(name ? name : "Lambda") {}
 
 	Result handle(Machine<Traits> &sm, const typename Traits::Event &ev) override { return handle_ ? handle_(sm, ev) : Result::Pass; }
+	Result query(const Machine<Traits> &sm, const typename Traits::Event &ev) const override { return query_ ? query_(sm, ev) : Result::Pass; }
 	void   on_entry(Machine<Traits> &sm) override {
         if (entry_) { entry_(sm); }
 	}
 	void on_exit(Machine<Traits> &sm) override {
 		if (exit_) { exit_(sm); }
 	}
-	const char *name() const override { return name_.c_str(); }
+	const char *name() const override { return name_.c_str(); }
+
+private:
+	bool may_transition() const override { return handle_ || entry_ || exit_; }
+	bool may_handle() const override { return static_cast<bool>(handle_); }
+
+	HandleFn    handle_ = nullptr;
+	QueryFn     query_  = nullptr;
+	EntryFn     entry_  = nullptr;
+	ExitFn      exit_   = nullptr;
+	std::string name_   = "Lambda";
+};
+
+// ============================================================================
+// Machine
+// ============================================================================
+
+template <typename Traits>
+class Machine {
+	friend class Scope<Traits>;
+
+	using Context = typename Traits::Context;
+	using Event   = typename Traits::Event;
+	using StateID = typename Traits::StateID;
+
+	using ContextStorage = typename detail::context_storage<Traits>::type;
+	using ContextHolder  = detail::ContextHolder<Context, ContextStorage>;
+	using Entry          = std::pair<StateID, Owned<State<Traits>>>;
+	using Registry       = std::vector<Entry, ResourceAllocator<Entry>>;
+	using Interned       = std::vector<State<Traits> *, ResourceAllocator<State<Traits> *>>;
+
+	enum class Phase { Idle, Run, Entry, Exit };
+
+public:
+	/// @brief Condition attached to a completion transition
+	using Guard = std::function<bool(Machine<Traits> &)>;
+
+private:
+	// Whether `Traits::ConcurrentQueries` opted into `query()`; other machines never touch the seqlock
+	enum : bool { queries = detail::concurrent_queries<Traits>::value };
+
+	using Clock = std::chrono::steady_clock;
+
+	// Token bucket for one event type, active while the current state is inside `scope`
+	struct RateLimit {
+		std::size_t       type;
+		State<Traits>    *scope;
+		double            rate;
+		double            burst;
+		double            tokens;
+		Clock::time_point last;
+	};
+
+	ContextHolder       ctx_;
+	MemoryResource     *resource_ = default_resource();
+	LambdaState<Traits> root_     = {"Root"};
+	Registry            registry_;
+	Interned            interned_;  // State by `State::index()`, null for removed states and the root
+
+	State<Traits> *active_state_    = nullptr;
+	State<Traits> *executing_state_ = nullptr;
+	State<Traits> *pending_state_   = nullptr;
+
+	Phase phase_ = Phase::Idle;
+
+	struct EventWrapperBase {
+		std::size_t type;
+		explicit EventWrapperBase(std::size_t t) : type(t) {}
+		virtual ~EventWrapperBase()      = default;
+		virtual const Event &get() const = 0;
+	};
+
+	template <typename T>
+	struct EventWrapper : EventWrapperBase {
+		T payload;
+		EventWrapper(const T &t) : EventWrapperBase(event_type<T>()), payload(t) {}
+		const Event &get() const override { return payload; }
+	};
+
+	// Type index used for filtering and rate limits, whether an event is dispatched or posted; dispatching the base
+	// `Event` type opts out of filtering because its dynamic type is unknown
+	enum : std::size_t { any_type = static_cast<std::size_t>(-1) };
+	template <typename E>
+	static std::size_t event_type() {
+		return std::is_same<E, Event>::value ? any_type : detail::type_index<E>();
+	}
+
+	using EventQueue = std::queue<Owned<EventWrapperBase>, std::deque<Owned<EventWrapperBase>, ResourceAllocator<Owned<EventWrapperBase>>>>;
+
+	using Edge = std::pair<State<Traits> *, StateID>;
+
+	struct Completion {
+		State<Traits> *from;
+		StateID        to;
+		State<Traits> *target;
+		Guard          guard;
+	};
+
+	// Bookkeeping of optional features, allocated from `resource_` the first time a scope or caller uses one, so
+	// that a plain machine in a large fleet pays a single pointer for all of them
+	struct Extras {
+		ResourceDeleter                 owner;  // Returns this block to the resource it came from
+		std::vector<RateLimit>          limits;
+		std::vector<Edge>               edges;  // Declared targets, kept until the analysis at `start()`
+		std::vector<Completion>         completions;
+		std::vector<StateID>            unreachable;
+		std::vector<Observer<Traits> *> observers;
+		std::vector<char>               gone;  // Scratch for `remove()`: subtree membership by index from the removed state
+		Stats                           stats;
+
+		// Accept masks indexed by `State::index_`, `words` 64-bit words per state
+		std::vector<std::pair<State<Traits> *, std::size_t>> accept_decl;
+		std::vector<std::uint64_t>                           own_masks;
+		std::vector<std::uint64_t>                           path_masks;
+		std::vector<std::uint64_t>                           any_mask;     // Union over all states
+		std::vector<std::uint32_t>                           type_slot;    // Event type -> dense per-machine type, 0 if never declared
+		std::size_t                                          types = 0;    // Distinct types declared with `Scope::accepts`
+		std::vector<std::uint32_t>                           route_index;  // (state, dense type) -> offset in `routes`, 0 if unresolved
+		std::vector<State<Traits> *>                         routes;
+		std::size_t                                          words    = 0;
+		bool                                                 any_open = false;
+
+		// Seqlock shared with `query()` readers; only used when `Traits::ConcurrentQueries` opts in, in which case
+		// the constructor allocates this block before another thread can see the machine
+		std::atomic<std::uint64_t>         seq{0};            // Odd while the owner thread is changing the machine
+		std::atomic<const State<Traits> *> visible{nullptr};  // `active_state_` as published to `query()` readers
+		std::atomic<std::uint32_t>         readers{0};        // `query()` calls currently walking states
+	};
+
+	EventQueue    event_queue_;
+	Extras       *extras_     = nullptr;  // Owned through `Extras::owner`, keeping the deleter out of the machine
+	std::uint32_t sorted_     = 0;        // Leading registry entries kept in `StateID` order
+	std::uint32_t next_index_ = 1;        // Index 0 is the root
+
+	bool filtering_ = false;  // Some state declared `Scope::accepts`; implies `extras_`
+	bool declared_  = false;
+	bool prune_     = false;
+
+	bool has_pending_    = false;
+	bool is_started_     = false;
+	bool is_terminated_  = false;
+	bool is_handled_     = false;
+	bool is_dispatching_ = false;
+
+public:
+	/// @brief Callback told about a post refused by admission control, on the posting thread
+	using Shed = std::function<void(const Event &, std::chrono::nanoseconds predicted)>;
+
+	/// @brief Completion hook of one post, run once with its context when the post resolves
+	using Done = void (*)(void *ctx);
+
+private:
+	// Outcome of one posted event; recycled through `Inbox::free`, guarded by `Inbox::mutex`
+	struct TicketSlot {
+		int         refs    = 0;
+		bool        done    = false;
+		bool        handled = false;
+		bool        refused = false;  // Resolved at post time without running
+		StateID     state   = StateID{};
+		TicketSlot *next    = nullptr;
+	};
+
+	struct Posted {
+		EventWrapperBase       *wrapper;  // Constructed in `Inbox::pool`
+		std::uint32_t           bytes;
+		std::uint32_t           align;
+		TicketSlot             *slot;
+		std::size_t             type;
+		std::int64_t            charge;  // Service time added to `Inbox::backlog` at post
+		Done                    done;
+		void                   *done_ctx;
+	};
+
+	// Copies of posted events, recycled per size class so a steady stream of posts stops allocating; chunks start
+	// small and double, keeping an idle machine's inbox cheap. Guarded by `Inbox::mutex` like the rest of the inbox.
+	class PostPool : public PoolResource {
+		std::vector<std::pair<void *, std::size_t>> chunks_;
+		std::size_t                                 next_ = 256;
+
+	protected:
+		void *refill(std::size_t min_bytes, std::size_t &got) override {
+			chunks_.reserve(chunks_.size() + 1);
+			got = std::max(next_, min_bytes);
+			void *chunk = default_resource()->allocate(got, alignment);
+			chunks_.emplace_back(chunk, got);
+			next_ = std::min<std::size_t>(next_ * 2, max_block);
+			return chunk;
+		}
+
+	public:
+		PostPool() = default;
+		~PostPool() override {
+			for (const auto &c : chunks_) { default_resource()->deallocate(c.first, c.second, alignment); }
+		}
+
+		PostPool(const PostPool &)            = delete;
+		PostPool &operator=(const PostPool &) = delete;
+	};
+
+	// Events posted from other threads, created on first `post()`
+	struct Inbox {
+		std::mutex              mutex;
+		std::condition_variable resolved;
+		std::deque<TicketSlot>  slots;
+		TicketSlot             *free = nullptr;
+		PostPool                pool;
+		std::vector<Posted>     items;
+		std::vector<Posted>     batch;  // Owner thread only: taken from `items` by `drain()`, run from `batch_pos`
+		std::size_t             batch_pos = 0;
+		std::uint64_t           rejected = 0;
+		std::uint64_t           shed     = 0;
+
+		using Sample = std::pair<std::size_t, std::int64_t>;  // (event type, moving average of ns per run)
+
+		// Admission control: predicted delay is the backlog plus the new event's own service time
+		std::int64_t        slo     = 0;  // Bound in ns; 0 admits everything
+		std::int64_t        backlog = 0;  // Estimated ns of posted events not yet resolved
+		std::vector<Sample> service;      // Sorted by type
+		Shed                on_shed;
+
+		// Copy of the machine's union accept mask, republished by the owner whenever its topology changes
+		std::vector<std::uint64_t> accepts;
+		bool                       filtering = false;
+		bool                       open      = false;
+
+		bool accepted(std::size_t type) const {
+			return !filtering || open || type == any_type || test_bit(accepts.data(), accepts.size(), type);
+		}
+
+		// Only the types this machine has run get an entry, however many the program numbers
+		std::int64_t estimate(std::size_t type) const {
+			auto it = std::lower_bound(service.begin(), service.end(), Sample(type, 0), by_type);
+			return it != service.end() && it->first == type ? it->second : 0;
+		}
+
+		void sample(std::size_t type, std::int64_t ns) {
+			auto it = std::lower_bound(service.begin(), service.end(), Sample(type, 0), by_type);
+			if (it == service.end() || it->first != type) {
+				service.insert(it, Sample(type, ns));
+			} else {
+				it->second += (ns - it->second) / 8;
+			}
+		}
+
+		static bool by_type(const Sample &a, const Sample &b) { return a.first < b.first; }
+
+		TicketSlot *acquire() {
+			TicketSlot *slot = free;
+			if (slot) {
+				free = slot->next;
+			} else {
+				slots.emplace_back();
+				slot = &slots.back();
+			}
+			*slot = TicketSlot();
+			return slot;
+		}
+
+		void release(TicketSlot *slot) {
+			if (--slot->refs == 0) {
+				slot->next = free;
+				free       = slot;
+			}
+		}
+
+		~Inbox() {
+			for (std::size_t i = batch_pos; i < batch.size(); ++i) { batch[i].wrapper->~EventWrapperBase(); }
+			for (auto &p : items) { p.wrapper->~EventWrapperBase(); }
+		}
+	};
+
+	std::atomic<Inbox *> inbox_{nullptr};
+
+	// Open a write section for concurrent `query()` readers; nested sections are absorbed by the outermost, and
+	// machines that did not opt in compile it away
+	class Writing {
+		std::atomic<std::uint64_t> *seq_ = nullptr;  // Null unless this is the outermost section
+
+	public:
+		explicit Writing(Machine &sm) {
+			if (!queries) { return; }
+			std::atomic<std::uint64_t> &seq = sm.extras_->seq;
+			if (seq.load(std::memory_order_relaxed) & 1) { return; }
+			seq_ = &seq;
+			seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+		~Writing() {
+			if (seq_) { seq_->store(seq_->load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+		}
+
+		Writing(const Writing &)            = delete;
+		Writing &operator=(const Writing &) = delete;
+	};
+
+	// Move the active state and publish it to `query()`; `parent_` links never change once a state is published
+	void activate(State<Traits> *s) {
+		active_state_ = s;
+		if (queries) { extras_->visible.store(s, std::memory_order_release); }
+	}
+
+	// Wait until no `query()` still walks states from before the current write section, so they can be freed
+	void quiesce() const {
+		if (!queries) { return; }
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		while (extras_->readers.load(std::memory_order_acquire) != 0) { std::this_thread::yield(); }
+	}
+
+public:
+	/// @brief Future-like handle to the outcome of an event passed to `post()`
+	/// @note Slots are pooled per machine, so a ticket must not outlive the machine that issued it
+	class Ticket {
+		friend class Machine;
+
+		Inbox      *inbox_ = nullptr;
+		TicketSlot *slot_  = nullptr;
+
+		Ticket(Inbox *inbox, TicketSlot *slot) : inbox_(inbox), slot_(slot) {}
+
+		void reset() {
+			if (!slot_) { return; }
+			std::lock_guard<std::mutex> lock(inbox_->mutex);
+			inbox_->release(slot_);
+			slot_ = nullptr;
+		}
+
+	public:
+		Ticket() = default;
+		Ticket(Ticket &&other) : inbox_(other.inbox_), slot_(other.slot_) { other.slot_ = nullptr; }
+		Ticket &operator=(Ticket &&other) {
+			if (this != &other) {
+				reset();
+				inbox_       = other.inbox_;
+				slot_        = other.slot_;
+				other.slot_  = nullptr;
+			}
+			return *this;
+		}
+		~Ticket() { reset(); }
+
+		Ticket(const Ticket &)            = delete;
+		Ticket &operator=(const Ticket &) = delete;
+
+		/// @brief Whether this ticket refers to a posted event
+		/// @note A ticket that does not, default-constructed or moved from, reads as a refused post: ready, unhandled
+		bool valid() const { return slot_ != nullptr; }
+
+		/// @brief Whether the event's run-to-completion step has finished
+		bool ready() const {
+			if (!slot_) { return true; }
+			std::lock_guard<std::mutex> lock(inbox_->mutex);
+			return slot_->done;
+		}
+
+		/// @brief Block until the event's run-to-completion step has finished
+		void wait() const {
+			if (!slot_) { return; }
+			std::unique_lock<std::mutex> lock(inbox_->mutex);
+			inbox_->resolved.wait(lock, [this] { return slot_->done; });
+		}
+
+		/// @brief Block until the step has finished or `timeout` elapsed
+		/// @return True if the step has finished
+		template <typename Rep, typename Period>
+		bool wait_for(const std::chrono::duration<Rep, Period> &timeout) const {
+			if (!slot_) { return true; }
+			std::unique_lock<std::mutex> lock(inbox_->mutex);
+			return inbox_->resolved.wait_for(lock, timeout, [this] { return slot_->done; });
+		}
+
+		/// @brief Wait, then report whether some state returned `Result::Done` for the event
+		bool handled() const {
+			wait();
+			return slot_ && slot_->handled;
+		}
+
+		/// @brief Wait, then report the active state right after the event's step
+		/// @return The state ID, or `StateID{}` if the post was refused or the machine was not running
+		StateID state() const {
+			wait();
+			return slot_ ? slot_->state : StateID{};
+		}
+
+		/// @brief Whether the post was turned away by `Scope::accepts` or `admission()` instead of being queued
+		bool refused() const { return !slot_ || slot_->refused; }  // Set before `post()` returns and never changed
+	};
+
+	template <typename... Args>
+	explicit Machine(Args &&...args) : ctx_(std::forward<Args>(args)...) {
+		if (queries) { extras(); }
+	}
+
+	/// @brief Draw states, queued events and the registry from `with.resource` from construction on, so the
+	///        machine never touches `default_resource()`; `use_resource()` after construction still allocates once
+	/// @param args Forwarded to the context
+	template <typename... Args>
+	explicit Machine(WithResource with, Args &&...args)
+		: ctx_(std::forward<Args>(args)...),
+		  resource_(with.resource),
+		  registry_(ResourceAllocator<Entry>(with.resource)),
+		  interned_(ResourceAllocator<State<Traits> *>(with.resource)),
+		  event_queue_(ResourceAllocator<Owned<EventWrapperBase>>(with.resource)) {
+		if (queries) { extras(); }
+	}
+
+	~Machine() {
+		delete inbox_.load(std::memory_order_acquire);
+		if (extras_) { ResourceDeleter(extras_->owner)(extras_); }
+	}
+
+	Machine(const Machine &)            = delete;
+	Machine &operator=(const Machine &) = delete;
+
+	Context       &context() { return *ctx_.get(); }
+	const Context &context() const { return *ctx_.get(); }
+	Context       *operator->() { return ctx_.get(); }
+	const Context *operator->() const { return ctx_.get(); }
+
+	/// @brief Point an `ExternalContext` machine at another context, e.g. after its arena was compacted
+	/// @param ctx Replacement context; the previous one is left untouched
+	void rebind_context(Context &ctx) {
+		static_assert(std::is_same<ContextStorage, ExternalContext>::value, "Traits::ContextStorage must be ExternalContext");
+		ctx_.rebind(ctx);
+	}
+
+	/// @brief Indicates whether the state machine has been started
+	/// @return True if `start()` was called and the machine is not terminated
+	bool started() const { return is_started_; }
+
+	/// @brief Indicates whether the machine has been requested to terminate
+	/// @return True if `stop()` was called or termination was triggered internally
+	bool terminated() const { return is_terminated_; }
+
+	/// @brief Get the identifier of the current active state
+	/// @return The active state's `StateID`, or default-constructed `StateID{}` if none
+	StateID current_state_id() const { return active_state_ ? active_state_->id_ : StateID{}; }
+
+	/// @brief Get the current active state
+	/// @return The innermost active state, or null before `start()`
+	const State<Traits> *current_state() const { return active_state_; }
+
+	/// @brief Resolve a state ID once, e.g. from configuration, for `transition(StateRef)` and `active(StateRef)`
+	/// @throws std::invalid_argument If the state is unknown
+	StateRef intern(StateID id) const {
+		auto it = std::lower_bound(registry_.begin(), registry_.begin() + static_cast<std::ptrdiff_t>(sorted_), id,
+								   [](const Entry &entry, const StateID &val) { return entry.first < val; });
+		if (it == registry_.begin() + static_cast<std::ptrdiff_t>(sorted_) || !(it->first == id)) { throw std::invalid_argument("State ID not found"); }
+		return StateRef(it->second->index_);
+	}
+
+	/// @brief Whether the state is on the active path, without comparing IDs
+	bool active(StateRef ref) const {
+		for (const State<Traits> *s = active_state_; s; s = s->parent_) {
+			if (s->index_ == ref.index) { return s != &root_; }
+		}
+		return false;
+	}
+
+	/// @brief Allocate states, queued events and the state registry from `resource`
+	/// @param resource Backend that must outlive the machine
+	/// @throws std::logic_error If called while started and not terminated
+	void use_resource(MemoryResource &resource) {
+		if (is_started_ && !is_terminated_) { throw std::logic_error("Cannot change resource while started"); }
+		Writing writing(*this);
+		activate(nullptr);
+		quiesce();
+		resource_    = &resource;
+		registry_    = Registry(ResourceAllocator<Entry>(resource_));
+		interned_    = Interned(ResourceAllocator<State<Traits> *>(resource_));
+		event_queue_ = EventQueue(typename EventQueue::container_type(ResourceAllocator<Owned<EventWrapperBase>>(resource_)));
+	}
+
+	/// @brief Destroy states found unreachable by the topology analysis at `start()`
+	/// @param enable Takes effect on the next `start()`
+	/// @note Transitions to a pruned state fail as if it was never declared
+	void prune_unreachable(bool enable) { prune_ = enable; }
+
+	/// @brief States that no declared transition can reach from the initial state
+	/// @return Sorted IDs from the last `start()`; empty unless some scope declared `targets`
+	const std::vector<StateID> &unreachable_states() const {
+		static const std::vector<StateID> none;
+		return extras_ ? extras_->unreachable : none;
+	}
+
+	/// @brief Counters of events rejected before reaching any handler
+	const Stats &stats() const {
+		static const Stats none;
+		return extras_ ? extras_->stats : none;
+	}
+
+	/// @brief Whether some state returned `Result::Done` in the most recent run-to-completion step
+	bool handled() const { return is_handled_; }
+
+	/// @brief Report steps and transitions to `observer` until `unobserve()`
+	/// @param observer Must outlive its registration
+	/// @throws std::logic_error If called from inside a handler or action
+	void observe(Observer<Traits> &observer) {
+		if (is_dispatching_ || phase_ != Phase::Idle) { throw std::logic_error("Cannot add an observer while dispatching"); }
+		extras().observers.push_back(&observer);
+	}
+
+	/// @brief Stop reporting to `observer`
+	/// @throws std::logic_error If called from inside a handler or action
+	void unobserve(Observer<Traits> &observer) {
+		if (is_dispatching_ || phase_ != Phase::Idle) { throw std::logic_error("Cannot remove an observer while dispatching"); }
+		if (!extras_) { return; }
+		auto &observers = extras_->observers;
+		observers.erase(std::remove(observers.begin(), observers.end(), &observer), observers.end());
+	}
+
+	/// @brief Build the state tree and start the machine at the given initial state
+	/// @tparam F Callable type with signature `void(Scope<Traits>&)`
+	/// @param initial_id Identifier of the initial state to enter
+	/// @param fn Callback to declare states and hierarchy under the root scope
+	/// @param root_handler Optional root event handler for top-level match
+	/// @throws std::logic_error If called while already started and not terminated
+	/// @throws std::invalid_argument If the initial state ID is not found
+	template <class F>
+	void start(StateID initial_id, F &&fn, typename LambdaState<Traits>::HandleFn root_handler = nullptr) {
+		if (is_started_ && !is_terminated_) { throw std::logic_error("Cannot already started"); }
+		build(std::forward<F>(fn), std::move(root_handler));
+
+		auto *init = get_state(initial_id);
+		if (!init) throw std::invalid_argument("Initial state ID not found");
+		prepare(init);
+
+		is_started_ = true;
+		activate(&root_);
+
+		WatchSlot *watch = detail::watch_slot();
+		settle(init, watch);
+		process_pending(watch);
+	}
+
+	/// @brief Build the state tree and continue in a previously active state without running any action
+	/// @tparam F Callable type with signature `void(Scope<Traits>&)`
+	/// @param index `State::index()` recorded before a restart; `fn` must declare the same tree in the same order
+	/// @param fn Callback to declare states and hierarchy under the root scope
+	/// @param root_handler Optional root event handler for top-level match
+	/// @throws std::logic_error If called while already started and not terminated
+	/// @throws std::invalid_argument If no state has the given index
+	template <class F>
+	void resume(std::uint32_t index, F &&fn, typename LambdaState<Traits>::HandleFn root_handler = nullptr) {
+		if (is_started_ && !is_terminated_) { throw std::logic_error("Cannot already started"); }
+		build(std::forward<F>(fn), std::move(root_handler));
+
+		State<Traits> *at = index < interned_.size() ? interned_[index] : nullptr;
+		if (!at) { throw std::invalid_argument("State index not found"); }
+		prepare(at);
+
+		Writing writing(*this);
+		is_started_ = true;
+		activate(at);
+	}
+
+	/// @brief Request termination; subsequent events and transitions are ignored
+	void stop() {
+		if (is_terminated_) { return; }
+		is_terminated_ = true;
+		if (extras_) {
+			for (auto *o : extras_->observers) { o->on_stop(*this); }
+		}
+	}
+
+	/// @brief Add states to a running machine between dispatches
+	/// @tparam F Callable type with signature `void(Scope<Traits>&)`
+	/// @param parent_id Identifier of the existing state that becomes the parent of the new states
+	/// @param fn Callback declaring the new subtree, as in `start()`
+	/// @throws std::logic_error If not running or called from inside a handler or action
+	/// @throws std::invalid_argument If the parent is unknown or a new ID is already used; the machine is left unchanged
+	/// @note The new states are sorted and merged into the registry, which costs time linear in the number of
+	///       states, but no existing state is rebuilt. Reachability analysis is not rerun.
+	template <class F>
+	void insert(StateID parent_id, F &&fn) {
+		auto *parent = get_state(parent_id);
+		if (!parent) { throw std::invalid_argument("Parent state ID not found"); }
+		insert_under(parent, std::forward<F>(fn));
+	}
+
+	/// @brief Add top-level states to a running machine between dispatches
+	template <class F>
+	void insert(F &&fn) {
+		insert_under(&root_, std::forward<F>(fn));
+	}
+
+	/// @brief Remove a state and all of its descendants from a running machine between dispatches
+	/// @param id Identifier of the subtree root
+	/// @throws std::logic_error If not running, called from inside a handler or action, the state is on the active
+	///         path, or a completion transition of a state outside the subtree targets it; the machine is left unchanged
+	/// @throws std::invalid_argument If the state is unknown
+	/// @note Linear in the number of states
+	void remove(StateID id) {
+		ensure_editable();
+		Writing writing(*this);
+		auto *target = get_state(id);
+		if (!target) { throw std::invalid_argument("State ID not found"); }
+		if (is_within(active_state_, target)) { throw std::logic_error("Cannot remove a state on the active path"); }
+
+		// Mark the subtree by index before changing anything. A parent is always registered before its children,
+		// so descendants are numbered after `target` and one ascending pass from it sees every parent's mark first.
+		Extras             &x     = extras();
+		auto               &gone  = x.gone;
+		const std::uint32_t first = target->index_;
+		gone.assign(interned_.size() - first, 0);
+		gone[0] = 1;
+		for (std::uint32_t i = first + 1; i < interned_.size(); ++i) {
+			const State<Traits> *s = interned_[i];
+			if (s && s->parent_->index_ >= first && gone[s->parent_->index_ - first]) { gone[i - first] = 1; }
+		}
+
+		auto inside = [&](const State<Traits> *s) { return s && s->index_ >= first && gone[s->index_ - first]; };
+		for (const Completion &c : x.completions) {
+			if (!inside(c.from) && inside(c.target)) { throw std::logic_error("Cannot remove a completion target of a remaining state"); }
+		}
+		quiesce();
+
+		for (std::uint32_t i = first; i < interned_.size(); ++i) {
+			if (gone[i - first]) { interned_[i] = nullptr; }
+		}
+		x.limits.erase(std::remove_if(x.limits.begin(), x.limits.end(), [&](const RateLimit &l) { return inside(l.scope); }), x.limits.end());
+		x.completions.erase(std::remove_if(x.completions.begin(), x.completions.end(), [&](const Completion &c) { return inside(c.from) || inside(c.target); }),
+							x.completions.end());
+		registry_.erase(std::remove_if(registry_.begin(), registry_.end(), [&](const Entry &e) { return inside(e.second.get()); }), registry_.end());
+		sorted_ = static_cast<std::uint32_t>(registry_.size());
+	}
+
+	/// @brief Schedule a transition to the target state (deferred execution during dispatch/entries, immediate if idle)
+	/// @param target_id Identifier of the destination state
+	/// @throws std::runtime_error If called during Exit phase or target not found
+	void transition(StateID target_id) {
+		if (phase_ == Phase::Exit) { throw std::runtime_error("Cannot transition during Exit phase"); }
+		auto *dest = get_state(target_id);
+		if (!dest) { throw std::runtime_error("Target state ID not found"); }
+		request(dest);
+	}
+
+	/// @brief Schedule a transition to an interned state; an index lookup instead of an ID search
+	/// @throws std::runtime_error If called during Exit phase or the state no longer exists
+	void transition(StateRef target) {
+		if (phase_ == Phase::Exit) { throw std::runtime_error("Cannot transition during Exit phase"); }
+		auto *dest = target.index < interned_.size() ? interned_[target.index] : nullptr;
+		if (!dest) { throw std::runtime_error("Target state index not found"); }
+		request(dest);
+	}
+
+private:
+	void request(State<Traits> *dest) {
+		pending_state_ = dest;
+		has_pending_   = true;
+
+		if (phase_ == Phase::Idle && !is_dispatching_) { process_pending(detail::watch_slot()); }
+	}
+
+public:
+	/// @brief Dispatch an event, propagating from the active state up the parent chain
+	/// @param evt Event object; default-constructed indicates an empty event
+	/// @note No-op if not started or already terminated; if a pending transition or termination occurs, propagation stops and pending transitions are processed
+	template <typename E>
+	void dispatch(const E &evt) {
+		if (!is_started_ || is_terminated_) { return; }
+		if (filtering_) {
+			// Queued events may meet a different active path, so they are only checked against the whole machine here
+			const std::size_t type = event_type<E>();
+			if (is_dispatching_ ? !accepted_anywhere(type) : !accepted(active_state_, type)) {
+				++extras_->stats.unhandleable;
+				return;
+			}
+		}
+		if (limited() && !admit(event_type<E>())) {
+			++extras_->stats.rate_limited;
+			return;
+		}
+
+		if (is_dispatching_) {
+			event_queue_.push(make_owned<EventWrapper<E>>(*resource_, evt));
+			return;
+		}
+
+		is_dispatching_ = true;
+		step(evt, event_type<E>());
+		drain_queue();
+		is_dispatching_ = false;
+	}
+
+	/// @brief Dispatch with brace-initialization fallback
+	void dispatch(const Event &evt) { dispatch<Event>(evt); }
+
+	/// @brief Dispatch an empty default event
+	void dispatch() { dispatch<Event>(Event{}); }
+
+	/// @brief Run `query` handlers for `evt` from any thread, from the active state up the parent chain
+	/// @param evt Query event; handlers report through its `mutable` fields
+	/// @return True if some query handler returned `Result::Done`
+	/// @note Requires `static constexpr bool ConcurrentQueries = true` in the traits; without it steps skip the
+	///       seqlock entirely and this function does not compile.
+	///       Lock-free for the owner: the walk is retried whenever a step, transition or topology edit overlaps it,
+	///       so handlers may run several times and only the last attempt's answer counts. Context fields that
+	///       handlers read are written concurrently by the owner, so they must be `std::atomic`, accessed with
+	///       `memory_order_relaxed` on both sides; the retry keeps the values of one answer from the same step.
+	///       Handlers must never follow pointers the owner may free. States stay alive while a query walks them:
+	///       `remove()`, a restart and `use_resource()` wait for running queries before freeing any. The machine
+	///       itself must outlive every query, and it must not be called from this machine's own handlers or actions.
+	template <typename E>
+	bool query(const E &evt) const {
+		static_assert(queries, "Traits::ConcurrentQueries must be true to call query()");
+		Extras &x = *extras_;
+		for (;;) {
+			// Announce the walk before checking for a writer; `quiesce()` does the mirror image
+			x.readers.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const std::uint64_t begin = x.seq.load(std::memory_order_acquire);
+			if (begin & 1) {
+				x.readers.fetch_sub(1, std::memory_order_release);
+				std::this_thread::yield();
+				continue;
+			}
+			bool handled = false;
+			for (const State<Traits> *s = x.visible.load(std::memory_order_acquire); s; s = s->parent_) {
+				if (s->query(*this, evt) == Result::Done) {
+					handled = true;
+					break;
+				}
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const bool stable = x.seq.load(std::memory_order_relaxed) == begin;
+			x.readers.fetch_sub(1, std::memory_order_release);
+			if (stable) { return handled; }
+		}
+	}
+
+	/// @brief Hand an event to the machine from any thread; it runs on the next `drain()` by the owning thread
+	/// @param evt Event object, copied into a pool owned by the machine's inbox, so steady posting reuses memory
+	/// @param ahead Delay expected before the owner gets to this machine, added to the admission prediction
+	/// @return Ticket resolving after the event's run-to-completion step
+	/// @note Call only after `start()` has returned. Types no state accepts (`Scope::accepts`) and posts shed by
+	///       `admission()` are refused before the copy and resolve immediately as unhandled.
+	template <typename E>
+	Ticket post(const E &evt, std::chrono::nanoseconds ahead = std::chrono::nanoseconds::zero()) {
+		return post(evt, nullptr, nullptr, ahead);
+	}
+
+	/// @brief Post with a completion hook, for flow control that must not wait on tickets
+	/// @param done Run as `done(ctx)` once the post resolves: inside this call if it is refused, otherwise on the
+	///             owning thread right after the event's step. Must not throw.
+	/// @note Posts with a hook are never shed: the sender bounds them itself, as `CreditLink` does with credits, so
+	///       `admission()` counts them in the backlog but does not apply the SLO to them. Only `Scope::accepts` can
+	///       refuse one. Throws like `post(evt)` without running `done` when the event cannot be copied.
+	template <typename E>
+	Ticket post(const E &evt, Done done, void *ctx, std::chrono::nanoseconds ahead = std::chrono::nanoseconds::zero()) {
+		Inbox            &in   = inbox();
+		const std::size_t type = event_type<E>();
+
+		std::unique_lock<std::mutex> lock(in.mutex);
+		TicketSlot                  *slot = in.acquire();
+		if (!in.accepted(type)) {
+			++in.rejected;
+			slot->done    = true;
+			slot->refused = true;
+			slot->refs    = 1;
+			lock.unlock();
+			if (done) { done(ctx); }
+			return Ticket(&in, slot);
+		}
+
+		std::int64_t charge = 0;
+		if (in.slo > 0) {
+			charge                       = in.estimate(type);
+			const std::int64_t predicted = ahead.count() + in.backlog + charge;
+			if (!done && predicted > in.slo) {
+				++in.shed;
+				slot->done    = true;
+				slot->refused = true;
+				slot->refs    = 1;
+				Shed on_shed = in.on_shed;
+				lock.unlock();
+				if (on_shed) { on_shed(evt, std::chrono::nanoseconds(predicted)); }
+				return Ticket(&in, slot);
+			}
+			in.backlog += charge;
+		}
+		slot->refs = 2;
+		auto abandon = [&] {
+			in.backlog -= charge;
+			slot->refs = 1;
+			in.release(slot);
+		};
+
+		// Memory is taken under the lock; the copy, which may run user code, is made outside it
+		const std::uint32_t bytes = sizeof(EventWrapper<E>), align = alignof(EventWrapper<E>);
+		void               *mem   = nullptr;
+		try {
+			mem = in.pool.allocate(bytes, align);
+		} catch (...) {
+			abandon();
+			throw;
+		}
+		lock.unlock();
+
+		EventWrapperBase *wrapper = nullptr;
+		try {
+			wrapper = new (mem) EventWrapper<E>(evt);
+		} catch (...) {
+			lock.lock();
+			in.pool.deallocate(mem, bytes, align);
+			abandon();
+			throw;
+		}
+
+		lock.lock();
+		in.items.push_back({wrapper, bytes, align, slot, type, charge, done, ctx});
+		return Ticket(&in, slot);
+	}
 
-private:
-	HandleFn    handle_ = nullptr;
-	EntryFn     entry_  = nullptr;
-	ExitFn      exit_   = nullptr;
-	std::string name_   = "Lambda";
-};
+	/// @brief Refuse posts whose predicted delay exceeds `slo`, instead of letting the inbox grow without bound
+	/// @param slo Bound on queueing plus service time; zero turns admission control off
+	/// @param shed Optional callback for refused posts; their tickets resolve at once as unhandled
+	/// @note The prediction sums moving averages of recent service times per event type over the events still
+	///       queued. Service times are only measured while an SLO is set, so a type not run since then has an
+	///       estimate of zero and its first post is never shed for its own cost. Posts with a completion hook,
+	///       including `CreditLink` traffic, are never shed. May be called from any thread.
+	void admission(std::chrono::nanoseconds slo, Shed shed = nullptr) {
+		Inbox                      &in = inbox();
+		std::lock_guard<std::mutex> lock(in.mutex);
+		in.slo     = slo.count() > 0 ? slo.count() : 0;
+		in.on_shed = std::move(shed);
+	}
 
-// ============================================================================
-// Machine
-// ============================================================================
+	/// @brief Estimated time to run every event posted and not yet finished; callable from any thread
+	std::chrono::nanoseconds backlog() const {
+		Inbox *in = inbox_.load(std::memory_order_acquire);
+		if (!in) { return std::chrono::nanoseconds::zero(); }
+		std::lock_guard<std::mutex> lock(in->mutex);
+		return std::chrono::nanoseconds(in->backlog);
+	}
 
-template <typename Traits>
-class Machine {
-	friend class Scope<Traits>;
+	/// @brief Current `admission()` bound, zero while admission control is off; callable from any thread
+	std::chrono::nanoseconds admission_slo() const {
+		Inbox *in = inbox_.load(std::memory_order_acquire);
+		if (!in) { return std::chrono::nanoseconds::zero(); }
+		std::lock_guard<std::mutex> lock(in->mutex);
+		return std::chrono::nanoseconds(in->slo);
+	}
 
-	using Context = typename Traits::Context;
-	using Event   = typename Traits::Event;
-	using StateID = typename Traits::StateID;
+	/// @brief Moving average of the time posted `E` events took to run while admission control was on; callable from any thread
+	template <typename E>
+	std::chrono::nanoseconds service_time() const {
+		Inbox *in = inbox_.load(std::memory_order_acquire);
+		if (!in) { return std::chrono::nanoseconds::zero(); }
+		std::lock_guard<std::mutex> lock(in->mutex);
+		return std::chrono::nanoseconds(in->estimate(event_type<E>()));
+	}
 
-	enum class Phase { Idle, Run, Entry, Exit };
+	/// @brief Start loading what the next `drain()` touches first, for drivers that cycle through many machines
+	/// @param deep Also follow the active state, context and inbox pointers. That reads this object, so a
+	///             pipelined driver first calls `prefetch(false)` several machines ahead and `prefetch(true)`
+	///             once those lines had time to arrive.
+	/// @note Call from the owning thread; only hints the cache and never changes the machine.
+	void prefetch(bool deep = true) const {
+		if (!deep) {
+			detail::prefetch(&active_state_);
+			detail::prefetch(&inbox_);
+			detail::prefetch(&is_dispatching_);
+			return;
+		}
+		detail::prefetch(active_state_);
+		detail::prefetch(ctx_.get());
+		detail::prefetch(inbox_.load(std::memory_order_relaxed));
+	}
 
-private:
-	Context                                                         ctx_;
-	LambdaState<Traits>                                             root_ = {"Root"};
-	std::vector<std::pair<StateID, std::unique_ptr<State<Traits>>>> registry_;
+	/// @brief Run events posted so far, in posting order, on the calling (owning) thread
+	/// @param limit Maximum number of posted events to consume; the rest wait for the next call
+	/// @return Number of posted events consumed
+	/// @note Returns 0 when called from inside a handler or action. If a handler or action throws, that event
+	///       resolves as unhandled and the exception propagates; the transition it requested and the events it
+	///       dispatched are dropped, and later posts stay queued.
+	std::size_t drain(std::size_t limit = static_cast<std::size_t>(-1)) {
+		std::size_t resolved = 0;
+		return drain(limit, resolved);
+	}
 
-	State<Traits> *active_state_    = nullptr;
-	State<Traits> *executing_state_ = nullptr;
-	State<Traits> *pending_state_   = nullptr;
+	/// @brief `drain(limit)` reporting progress even when a handler throws
+	/// @param resolved Receives the number of posts resolved by this call, including one that threw
+	std::size_t drain(std::size_t limit, std::size_t &resolved) {
+		resolved  = 0;
+		Inbox *in = inbox_.load(std::memory_order_acquire);
+		if (!in || is_dispatching_) { return 0; }
+
+		// Service times only feed admission control, so they are skipped without an SLO; decided once per call so
+		// the batch left by a bounded call is timed like a fresh one
+		bool timed;
+		{
+			std::lock_guard<std::mutex> lock(in->mutex);
+			timed = in->slo > 0;
+		}
 
-	Phase phase_ = Phase::Idle;
+		// Finish the batch left by a bounded call, then take at most one fresh batch from the inbox
+		std::size_t count   = 0;
+		bool        swapped = false;
+		while (count < limit) {
+			if (in->batch_pos == in->batch.size()) {
+				if (swapped) { break; }
+				swapped = true;
+				in->batch.clear();
+				in->batch_pos = 0;
+				std::lock_guard<std::mutex> lock(in->mutex);
+				in->batch.swap(in->items);
+				if (in->rejected || in->shed) {
+					Stats &stats = extras().stats;
+					stats.unhandleable += in->rejected;
+					stats.shed += in->shed;
+					in->rejected = 0;
+					in->shed     = 0;
+				}
+				continue;
+			}
 
-	struct EventWrapperBase {
-		virtual ~EventWrapperBase()      = default;
-		virtual const Event &get() const = 0;
-	};
+			Posted &p = in->batch[in->batch_pos++];
+			if (in->batch_pos < in->batch.size()) { detail::prefetch(in->batch[in->batch_pos].wrapper); }
+			bool               handled = false;
+			StateID            state   = StateID{};
+			const std::int64_t begin   = timed ? detail::steady_ns() : 0;
+			try {
+				if (is_started_ && !is_terminated_) { run_posted(*p.wrapper, handled, state); }
+			} catch (...) {
+				p.wrapper->~EventWrapperBase();
+				resolve(*in, p, false, StateID{}, timed ? detail::steady_ns() - begin : -1);
+				resolved = count + 1;
+				throw;
+			}
+			p.wrapper->~EventWrapperBase();
+			resolve(*in, p, handled, state, timed ? detail::steady_ns() - begin : -1);
+			resolved = ++count;
+		}
+		return count;
+	}
 
-	template <typename T>
-	struct EventWrapper : EventWrapperBase {
-		T payload;
-		EventWrapper(const T &t) : payload(t) {}
-		const Event &get() const override { return payload; }
-	};
+private:
+	State<Traits> *get_state(StateID id) {
+		auto it = std::lower_bound(registry_.begin(), registry_.end(), id,
+								   [](const Entry &entry, const StateID &val) { return entry.first < val; });
 
-	std::queue<std::unique_ptr<EventWrapperBase>> event_queue_;
+		if (it != registry_.end() && it->first == id) { return it->second.get(); }
+		return nullptr;
+	}
 
-	bool has_pending_    = false;
-	bool is_started_     = false;
-	bool is_terminated_  = false;
-	bool is_handled_     = false;
-	bool is_dispatching_ = false;
+	Extras &extras() {
+		if (!extras_) {
+			Owned<Extras> x = make_owned<Extras>(*resource_);
+			x->owner        = x.get_deleter();
+			extras_         = x.release();
+		}
+		return *extras_;
+	}
 
-public:
-	template <typename... Args>
-	explicit Machine(Args &&...args) : ctx_(std::forward<Args>(args)...) {}
+	bool limited() const { return extras_ && !extras_->limits.empty(); }
 
-	Machine(const Machine &)            = delete;
-	Machine &operator=(const Machine &) = delete;
+	Inbox &inbox() {
+		Inbox *in = inbox_.load(std::memory_order_acquire);
+		if (in) { return *in; }
+		Inbox *created = new Inbox();
+		if (inbox_.compare_exchange_strong(in, created, std::memory_order_acq_rel)) { return *created; }
+		delete created;
+		return *in;
+	}
 
-	Context       &context() { return ctx_; }
-	const Context &context() const { return ctx_; }
-	Context       *operator->() { return &ctx_; }
-	const Context *operator->() const { return &ctx_; }
+	// Run queued events raised by handlers until the queue is empty
+	void drain_queue() {
+		while (!event_queue_.empty() && !is_terminated_) {
+			auto wrapper = std::move(event_queue_.front());
+			event_queue_.pop();
+			if (filtering_ && !accepted(active_state_, wrapper->type)) {
+				++extras_->stats.unhandleable;
+				continue;
+			}
+			step(wrapper->get(), wrapper->type);
+		}
+	}
 
-	/// @brief Indicates whether the state machine has been started
-	/// @return True if `start()` was called and the machine is not terminated
-	bool started() const { return is_started_; }
+	void run_posted(EventWrapperBase &wrapper, bool &handled, StateID &state) {
+		state = current_state_id();
+		if (filtering_ && !accepted(active_state_, wrapper.type)) {
+			++extras_->stats.unhandleable;
+			return;
+		}
+		if (limited() && !admit(wrapper.type)) {
+			++extras_->stats.rate_limited;
+			return;
+		}
+		is_dispatching_ = true;
+		try {
+			step(wrapper.get(), wrapper.type);
+			handled = is_handled_;
+			state   = current_state_id();
+			drain_queue();
+		} catch (...) {
+			abandon_step();
+			throw;
+		}
+		is_dispatching_ = false;
+	}
 
-	/// @brief Indicates whether the machine has been requested to terminate
-	/// @return True if `stop()` was called or termination was triggered internally
-	bool terminated() const { return is_terminated_; }
+	// Return to idle after a handler or action threw out of a step, so the machine can take the next event: the
+	// half-requested transition and the events raised during the step are dropped
+	void abandon_step() {
+		is_dispatching_  = false;
+		phase_           = Phase::Idle;
+		has_pending_     = false;
+		pending_state_   = nullptr;
+		executing_state_ = nullptr;
+		while (!event_queue_.empty()) { event_queue_.pop(); }
+	}
 
-	/// @brief Get the identifier of the current active state
-	/// @return The active state's `StateID`, or default-constructed `StateID{}` if none
-	StateID current_state_id() const { return active_state_ ? active_state_->id_ : StateID{}; }
+	// Settle a post whose event copy was already destroyed; `elapsed` is negative when the run was not timed
+	static void resolve(Inbox &in, const Posted &p, bool handled, const StateID &state, std::int64_t elapsed) {
+		{
+			std::lock_guard<std::mutex> lock(in.mutex);
+			in.pool.deallocate(p.wrapper, p.bytes, p.align);
+			p.slot->done    = true;
+			p.slot->handled = handled;
+			p.slot->state   = state;
+			in.release(p.slot);
+			in.backlog -= p.charge;
+			if (elapsed >= 0) { in.sample(p.type, elapsed); }
+		}
+		in.resolved.notify_all();
+		if (p.done) { p.done(p.done_ctx); }
+	}
 
-	/// @brief Build the state tree and start the machine at the given initial state
-	/// @tparam F Callable type with signature `void(Scope<Traits>&)`
-	/// @param initial_id Identifier of the initial state to enter
-	/// @param fn Callback to declare states and hierarchy under the root scope
-	/// @param root_handler Optional root event handler for top-level match
-	/// @throws std::logic_error If called while already started and not terminated
-	/// @throws std::invalid_argument If the initial state ID is not found
+	// Reset the machine and declare the state tree, leaving the registry sorted by ID
 	template <class F>
-	void start(StateID initial_id, F &&fn, typename LambdaState<Traits>::HandleFn root_handler = nullptr) {
+	void build(F &&fn, typename LambdaState<Traits>::HandleFn root_handler) {
 		static_assert(std::is_same<void, decltype(fn(std::declval<Scope<Traits> &>()))>::value, "F must be callable as void(Scope<Traits>&)");
-		if (is_started_ && !is_terminated_) { throw std::logic_error("Cannot already started"); }
-
+		Writing writing(*this);
+
+		sorted_ = 0;
+		if (extras_) {
+			extras_->limits.clear();
+			extras_->edges.clear();
+			extras_->completions.clear();
+			extras_->unreachable.clear();
+			extras_->accept_decl.clear();
+		}
+		next_index_     = 1;
+		declared_       = false;
+		filtering_      = false;
+		root_.declared_ = false;
+		root_.filters_  = false;
+		is_started_     = false;
+		is_terminated_  = false;
+		has_pending_    = false;
+		phase_          = Phase::Idle;
+		pending_state_  = nullptr;
+		activate(nullptr);
+		quiesce();
+		// Dropped together, so refs from the previous run fail like unknown IDs until `intern_all()` refills the table
 		registry_.clear();
-		is_started_    = false;
-		is_terminated_ = false;
-		has_pending_   = false;
-		phase_         = Phase::Idle;
-		active_state_  = nullptr;
-		pending_state_ = nullptr;
+		interned_.clear();
 
 		root_.handle_ = root_handler ? std::move(root_handler) : nullptr;
 		Scope<Traits> root_scope(this, &root_);
 		fn(root_scope);
 
-		std::sort(registry_.begin(), registry_.end(),
-				  [](const std::pair<StateID, std::unique_ptr<State<Traits>>> &a, const std::pair<StateID, std::unique_ptr<State<Traits>>> &b) {
-					  return a.first < b.first;
-				  });
-
-		auto *init = get_state(initial_id);
-		if (!init) throw std::invalid_argument("Initial state ID not found");
+		// IDs are only compared here, once sorted, rather than on every `Scope::state` call
+		std::sort(registry_.begin(), registry_.end(), [](const Entry &a, const Entry &b) { return a.first < b.first; });
+		if (has_duplicates(registry_.begin(), registry_.end())) {
+			registry_.clear();
+			throw std::invalid_argument("Duplicate StateID detected");
+		}
+		sorted_ = static_cast<std::uint32_t>(registry_.size());
+		intern_all();
+	}
 
-		is_started_   = true;
-		active_state_ = &root_;
+	static bool has_duplicates(typename Registry::const_iterator first, typename Registry::const_iterator last) {
+		return std::adjacent_find(first, last, [](const Entry &a, const Entry &b) { return a.first == b.first; }) != last;
+	}
 
-		do_transition(init);
-		process_pending();
+	// Map every `State::index()` to its state for `transition(StateRef)`; only a build fills the table from
+	// scratch, edits and pruning touch just the slots of the states they add or drop
+	void intern_all() {
+		interned_.assign(next_index_, nullptr);
+		for (const auto &e : registry_) { interned_[e.second->index_] = e.second.get(); }
 	}
 
-	/// @brief Request termination; subsequent events and transitions are ignored
-	void stop() { is_terminated_ = true; }
+	// Lookup structures that depend on where the machine starts
+	void prepare(State<Traits> *init) {
+		resolve_completions();
+		if (declared_) { analyze(init); }
+		if (filtering_) { build_filters(); }
+		publish_filter();
+	}
 
-	/// @brief Schedule a transition to the target state (deferred execution during dispatch/entries, immediate if idle)
-	/// @param target_id Identifier of the destination state
-	/// @throws std::runtime_error If called during Exit phase or target not found
-	void transition(StateID target_id) {
-		if (phase_ == Phase::Exit) { throw std::runtime_error("Cannot transition during Exit phase"); }
-		auto *dest = get_state(target_id);
-		if (!dest) { throw std::runtime_error("Target state ID not found"); }
+	// Hand the union accept mask to posting threads, which read it under the inbox lock instead of the owner's copy
+	void publish_filter() {
+		if (!filtering_ && !inbox_.load(std::memory_order_acquire)) { return; }
+		Inbox                      &in = inbox();
+		std::lock_guard<std::mutex> lock(in.mutex);
+		in.filtering = filtering_;
+		in.open      = filtering_ && extras_->any_open;
+		if (filtering_) {
+			in.accepts.assign(extras_->any_mask.begin(), extras_->any_mask.end());
+		} else {
+			in.accepts.clear();
+		}
+	}
 
-		pending_state_ = dest;
-		has_pending_   = true;
+	void ensure_editable() const {
+		if (!is_started_ || is_terminated_) { throw std::logic_error("Machine is not running"); }
+		if (is_dispatching_ || phase_ != Phase::Idle) { throw std::logic_error("Cannot edit topology during dispatch"); }
+	}
 
-		if (phase_ == Phase::Idle && !is_dispatching_) { process_pending(); }
+	template <class F>
+	void insert_under(State<Traits> *parent, F &&fn) {
+		static_assert(std::is_same<void, decltype(fn(std::declval<Scope<Traits> &>()))>::value, "F must be callable as void(Scope<Traits>&)");
+		ensure_editable();
+		Writing writing(*this);
+
+		Extras             &x               = extras();
+		const std::size_t   old_size        = registry_.size();
+		const std::size_t   old_completions = x.completions.size();
+		const std::size_t   old_limits      = x.limits.size();
+		const std::size_t   old_accepts     = x.accept_decl.size();
+		const std::uint32_t old_next        = next_index_;
+		const bool          was_filtering   = filtering_;
+		const bool          was_declared    = declared_;
+		// Declarations made directly in the parent's scope mark the existing parent itself
+		const bool          parent_declared  = parent->declared_;
+		const bool          parent_completes = parent->completes_;
+		const bool          parent_filters   = parent->filters_;
+		try {
+			Scope<Traits> scope(this, parent);
+			fn(scope);
+			// New IDs were checked against the sorted prefix as they were declared; check them among themselves
+			auto mid = registry_.begin() + static_cast<std::ptrdiff_t>(old_size);
+			std::sort(mid, registry_.end(), [](const Entry &a, const Entry &b) { return a.first < b.first; });
+			if (has_duplicates(mid, registry_.end())) { throw std::invalid_argument("Duplicate StateID detected"); }
+			for (auto it = x.completions.begin() + static_cast<std::ptrdiff_t>(old_completions); it != x.completions.end(); ++it) {
+				it->target = get_state_or_tail(it->to, old_size);
+				if (!it->target) { throw std::invalid_argument("Completion target state ID not found"); }
+			}
+		} catch (...) {
+			registry_.erase(registry_.begin() + static_cast<std::ptrdiff_t>(old_size), registry_.end());
+			x.completions.erase(x.completions.begin() + static_cast<std::ptrdiff_t>(old_completions), x.completions.end());
+			x.limits.erase(x.limits.begin() + static_cast<std::ptrdiff_t>(old_limits), x.limits.end());
+			x.accept_decl.erase(x.accept_decl.begin() + static_cast<std::ptrdiff_t>(old_accepts), x.accept_decl.end());
+			x.edges.clear();
+			next_index_        = old_next;
+			filtering_         = was_filtering;
+			declared_          = was_declared;
+			parent->declared_  = parent_declared;
+			parent->completes_ = parent_completes;
+			parent->filters_   = parent_filters;
+			throw;
+		}
+		x.edges.clear();
+
+		// New states hold the indices from `old_next` on; only their slots are filled
+		if (interned_.size() < next_index_) { interned_.resize(next_index_, nullptr); }
+		for (auto it = registry_.begin() + static_cast<std::ptrdiff_t>(old_size); it != registry_.end(); ++it) { interned_[it->second->index_] = it->second.get(); }
+
+		// Merge the new entries, already sorted, into the sorted registry and completion list
+		auto mid = registry_.begin() + static_cast<std::ptrdiff_t>(old_size);
+		std::inplace_merge(registry_.begin(), mid, registry_.end(), [](const Entry &a, const Entry &b) { return a.first < b.first; });
+		sorted_ = static_cast<std::uint32_t>(registry_.size());
+
+		const auto by_state = [](const Completion &a, const Completion &b) { return std::less<const State<Traits> *>()(a.from, b.from); };
+		auto       cmid     = x.completions.begin() + static_cast<std::ptrdiff_t>(old_completions);
+		std::stable_sort(cmid, x.completions.end(), by_state);
+		std::inplace_merge(x.completions.begin(), cmid, x.completions.end(), by_state);
+
+		if (filtering_ && !was_filtering) {
+			build_filters();
+		} else if (filtering_) {
+			extend_filters(parent, old_next);
+		}
+		publish_filter();
 	}
 
-	/// @brief Dispatch an event, propagating from the active state up the parent chain
-	/// @param evt Event object; default-constructed indicates an empty event
-	/// @note No-op if not started or already terminated; if a pending transition or termination occurs, propagation stops and pending transitions are processed
-	template <typename E>
-	void dispatch(const E &evt) {
-		if (!is_started_ || is_terminated_) { return; }
+	// Lookup over the sorted prefix of `registry_` and the separately sorted entries appended after it
+	State<Traits> *get_state_or_tail(StateID id, std::size_t sorted) {
+		const auto less = [](const Entry &entry, const StateID &val) { return entry.first < val; };
+		auto       end  = registry_.begin() + static_cast<std::ptrdiff_t>(sorted);
+		auto       it   = std::lower_bound(registry_.begin(), end, id, less);
+		if (it != end && it->first == id) { return it->second.get(); }
+		it = std::lower_bound(end, registry_.end(), id, less);
+		if (it != registry_.end() && it->first == id) { return it->second.get(); }
+		return nullptr;
+	}
 
-		if (is_dispatching_) {
-			event_queue_.push(std::unique_ptr<EventWrapperBase>(new EventWrapper<E>(evt)));
-			return;
+	// One run-to-completion step: propagate `evt` up from the active state, then settle pending transitions
+	void step(const Event &evt, std::size_t type) {
+		Writing    writing(*this);
+		WatchSlot *watch = detail::watch_slot();
+		Extras    *x     = extras_;
+		if (x) {
+			for (auto *o : x->observers) { o->on_dispatch(*this, evt, type); }
 		}
 
-		is_dispatching_ = true;
-		is_handled_     = false;
-		phase_          = Phase::Run;
+		is_handled_ = false;
+		phase_      = Phase::Run;
 
-		for (auto *s = active_state_; s; s = s->parent_) {
-			executing_state_ = s;
-			if (s->handle(*this, evt) == Result::Done) {
-				is_handled_ = true;
-				break;
+		if (filtering_ && type < x->words * 64) {
+			// Only the ancestors that can handle `type`, resolved once per (state, type)
+			for (std::size_t i = route(active_state_, type); x->routes[i]; ++i) {
+				if (visit(x->routes[i], evt, watch)) { break; }
+			}
+		} else {
+			for (auto *s = active_state_; s; s = s->parent_) {
+				if (visit(s, evt, watch)) { break; }
 			}
-			if (has_pending_ || is_terminated_) { break; }
 		}
 
 		phase_ = Phase::Idle;
-		process_pending();
+		if (has_pending_) { process_pending(watch); }
+		if (x) {
+			for (auto *o : x->observers) { o->on_step(*this); }
+		}
+	}
 
-		while (!event_queue_.empty() && !is_terminated_) {
-			auto wrapper = std::move(event_queue_.front());
-			event_queue_.pop();
+	// Run one handler; returns true when propagation must stop
+	bool visit(State<Traits> *s, const Event &evt, WatchSlot *watch) {
+		executing_state_ = s;
+		const bool done = watch ? handle_watched(s, evt, watch) : s->handle(*this, evt) == Result::Done;
+		if (done) {
+			is_handled_ = true;
+			return true;
+		}
+		return has_pending_ || is_terminated_;
+	}
 
-			is_handled_ = false;
-			phase_      = Phase::Run;
+	// The watched variants publish the running action to the thread's watchdog slot, which must be non-null
+	bool handle_watched(State<Traits> *s, const Event &evt, WatchSlot *watch) {
+		detail::WatchGuard guard(watch, s, "handle", typeid(evt).name());
+		return s->handle(*this, evt) == Result::Done;
+	}
 
-			for (auto *s = active_state_; s; s = s->parent_) {
-				executing_state_ = s;
-				if (s->handle(*this, wrapper->get()) == Result::Done) {
-					is_handled_ = true;
-					break;
-				}
-				if (has_pending_ || is_terminated_) { break; }
+	void enter(State<Traits> *s, WatchSlot *watch) {
+		executing_state_ = s;
+		if (!watch) { return s->on_entry(*this); }
+		detail::WatchGuard guard(watch, s, "on_entry", nullptr);
+		s->on_entry(*this);
+	}
+
+	void leave(State<Traits> *s, WatchSlot *watch) {
+		executing_state_ = s;
+		if (!watch) { return s->on_exit(*this); }
+		detail::WatchGuard guard(watch, s, "on_exit", nullptr);
+		s->on_exit(*this);
+	}
+
+	// Offset in `Extras::routes` of the null-terminated list of states from `s` upwards that may handle `type`
+	std::size_t route(State<Traits> *s, std::size_t type) {
+		Extras           &x     = *extras_;
+		const std::size_t dense = type < x.type_slot.size() ? x.type_slot[type] : 0;
+		auto             &slot  = x.route_index[s->index_ * (x.types + 1) + dense];
+		if (!slot) {
+			slot = static_cast<std::uint32_t>(x.routes.size());
+			for (auto *a = s; a; a = a->parent_) {
+				if ((!a->filters_ && a->may_handle()) || test_bit(&x.own_masks[a->index_ * x.words], x.words, type)) { x.routes.push_back(a); }
 			}
+			x.routes.push_back(nullptr);
+		}
+		return slot;
+	}
 
-			phase_ = Phase::Idle;
-			process_pending();
+	// Group completion transitions by source state, keeping declaration order within each state
+	void resolve_completions() {
+		if (!extras_) { return; }
+		auto &completions = extras_->completions;
+		for (auto &c : completions) {
+			c.target = get_state(c.to);
+			if (!c.target) { throw std::invalid_argument("Completion target state ID not found"); }
 		}
+		std::stable_sort(completions.begin(), completions.end(),
+						 [](const Completion &a, const Completion &b) { return std::less<const State<Traits> *>()(a.from, b.from); });
+	}
 
-		is_dispatching_ = false;
+	// Reachability from `init` over declared targets; states that may transition anywhere make every state reachable
+	void analyze(State<Traits> *init) {
+		Extras                      &x = *extras_;
+		std::vector<char>            reached(next_index_, 0);
+		std::vector<State<Traits> *> work;
+		bool                         open = false;
+
+		auto mark = [&](State<Traits> *s) {
+			for (; s && s != &root_ && !reached[s->index_]; s = s->parent_) {
+				reached[s->index_] = 1;
+				work.push_back(s);
+			}
+		};
+		const std::less<const State<Traits> *> before;
+		std::sort(x.edges.begin(), x.edges.end(), [&](const Edge &a, const Edge &b) { return before(a.first, b.first); });
+
+		std::vector<State<Traits> *> targets;
+		for (const auto &e : x.edges) {
+			auto *to = get_state(e.second);
+			if (!to) { throw std::invalid_argument("Declared target state ID not found"); }
+			targets.push_back(to);
+		}
+		auto follow = [&](State<Traits> *from) {
+			if (!from->declared_ && from->may_transition()) { open = true; }
+			auto it = std::lower_bound(x.edges.begin(), x.edges.end(), from, [&](const Edge &e, State<Traits> *s) { return before(e.first, s); });
+			for (; it != x.edges.end() && it->first == from; ++it) { mark(targets[it - x.edges.begin()]); }
+		};
+
+		follow(&root_);
+		mark(init);
+		while (!work.empty() && !open) {
+			auto *s = work.back();
+			work.pop_back();
+			follow(s);
+		}
+		x.edges.clear();
+		if (open) { return; }
+
+		for (const auto &entry : registry_) {
+			if (!reached[entry.second->index_]) { x.unreachable.push_back(entry.first); }
+		}
+		if (prune_) {
+			x.limits.erase(std::remove_if(x.limits.begin(), x.limits.end(), [&](const RateLimit &l) { return l.scope != &root_ && !reached[l.scope->index_]; }),
+						  x.limits.end());
+			x.completions.erase(std::remove_if(x.completions.begin(), x.completions.end(), [&](const Completion &c) { return !reached[c.from->index_]; }),
+							   x.completions.end());
+			x.accept_decl.erase(std::remove_if(x.accept_decl.begin(), x.accept_decl.end(),
+											  [&](const std::pair<State<Traits> *, std::size_t> &d) { return !reached[d.first->index_]; }),
+							   x.accept_decl.end());
+			for (std::uint32_t i = 1; i < next_index_; ++i) {
+				if (!reached[i]) { interned_[i] = nullptr; }
+			}
+			registry_.erase(std::remove_if(registry_.begin(), registry_.end(), [&](const Entry &e) { return !reached[e.second->index_]; }), registry_.end());
+			sorted_ = static_cast<std::uint32_t>(registry_.size());
+		}
 	}
 
-	/// @brief Dispatch with brace-initialization fallback
-	void dispatch(const Event &evt) { dispatch<Event>(evt); }
+	// Number the types in `x.accept_decl` not seen before; returns whether any were
+	bool number_types() {
+		Extras &x = *extras_;
+		const std::size_t before = x.types;
+		for (const auto &d : x.accept_decl) {
+			if (d.second >= x.type_slot.size()) { x.type_slot.resize(d.second + 1, 0); }
+			if (!x.type_slot[d.second]) { x.type_slot[d.second] = static_cast<std::uint32_t>(++x.types); }
+		}
+		return x.types != before;
+	}
 
-	/// @brief Dispatch an empty default event
-	void dispatch() { dispatch<Event>(Event{}); }
+	// Derive per-state path masks from the types declared with `Scope::accepts`
+	void build_filters() {
+		Extras &x = *extras_;
+		x.type_slot.clear();
+		x.types = 0;
+		number_types();
+
+		std::size_t max_type = 0;
+		for (const auto &d : x.accept_decl) { max_type = std::max(max_type, d.second); }
+		x.words = max_type / 64 + 1;
+		x.own_masks.assign(next_index_ * x.words, 0);
+		x.path_masks.assign(next_index_ * x.words, 0);
+		x.any_mask.assign(x.words, 0);
+		x.any_open = false;
+
+		for (const auto &d : x.accept_decl) {
+			x.own_masks[d.first->index_ * x.words + d.second / 64] |= std::uint64_t(1) << (d.second % 64);
+			x.any_mask[d.second / 64] |= std::uint64_t(1) << (d.second % 64);
+		}
+		x.accept_decl.clear();
 
-private:
-	State<Traits> *get_state(StateID id) {
-		auto it = std::lower_bound(registry_.begin(), registry_.end(), id,
-								   [](const std::pair<StateID, std::unique_ptr<State<Traits>>> &pair, const StateID &val) { return pair.first < val; });
+		std::vector<char> done(next_index_, 0);
+		fill_path(&root_, done);
+		for (auto &entry : registry_) { fill_path(entry.second.get(), done); }
 
-		if (it != registry_.end() && it->first == id) { return it->second.get(); }
-		return nullptr;
+		// Types no state declares share dense slot 0, so the table grows with this machine's types, not the program's
+		x.route_index.assign(next_index_ * (x.types + 1), 0);
+		x.routes.assign(1, nullptr);
+	}
+
+	// Give newly inserted states (indexed from `first`) their masks, widening every mask only if a new event type
+	// needs it. The insert may also have declared types for `parent` itself, so every state under it is redone.
+	void extend_filters(State<Traits> *parent, std::uint32_t first) {
+		Extras &x = *extras_;
+		std::size_t max_type = x.words * 64 - 1;
+		for (const auto &d : x.accept_decl) { max_type = std::max(max_type, d.second); }
+		const std::size_t words = max_type / 64 + 1;
+		const bool        grown = number_types();
+
+		if (words != x.words) {
+			std::vector<std::uint64_t> own(next_index_ * words, 0), path(next_index_ * words, 0);
+			for (std::size_t i = 0; i < first; ++i) {
+				std::copy(&x.own_masks[i * x.words], &x.own_masks[i * x.words] + x.words, &own[i * words]);
+				std::copy(&x.path_masks[i * x.words], &x.path_masks[i * x.words] + x.words, &path[i * words]);
+			}
+			x.own_masks.swap(own);
+			x.path_masks.swap(path);
+			x.any_mask.resize(words, 0);
+			x.words = words;
+		} else {
+			x.own_masks.resize(next_index_ * x.words, 0);
+			x.path_masks.resize(next_index_ * x.words, 0);
+		}
+		if (grown) {
+			// A new type changes the stride of `x.route_index`; cached routes are resolved again on demand
+			x.route_index.assign(next_index_ * (x.types + 1), 0);
+			x.routes.assign(1, nullptr);
+		} else {
+			x.route_index.resize(next_index_ * (x.types + 1), 0);
+		}
+
+		for (const auto &d : x.accept_decl) {
+			x.own_masks[d.first->index_ * x.words + d.second / 64] |= std::uint64_t(1) << (d.second % 64);
+			x.any_mask[d.second / 64] |= std::uint64_t(1) << (d.second % 64);
+		}
+		x.accept_decl.clear();
+
+		// Parents are registered before their children, so one ascending pass from `parent` finds its subtree
+		std::vector<char> done(next_index_, 1);
+		const std::uint32_t top = parent->index_;
+		done[top]               = 0;
+		for (std::uint32_t i = top + 1; i < next_index_; ++i) {
+			if (interned_[i] && !done[interned_[i]->parent_->index_]) { done[i] = 0; }
+		}
+		for (std::uint32_t i = top; i < next_index_; ++i) {
+			if (done[i]) { continue; }
+			// Cached routes start at the state itself, so only rows inside the subtree can have changed
+			std::fill(&x.route_index[i * (x.types + 1)], &x.route_index[i * (x.types + 1)] + x.types + 1, 0);
+		}
+		fill_path(parent, done);
+		for (std::uint32_t i = top + 1; i < next_index_; ++i) {
+			if (interned_[i]) { fill_path(interned_[i], done); }
+		}
+	}
+
+	void fill_path(State<Traits> *s, std::vector<char> &done) {
+		Extras &x = *extras_;
+		if (done[s->index_]) { return; }
+		done[s->index_] = 1;
+
+		const bool all = !s->filters_ && s->may_handle();
+		x.any_open      = x.any_open || all;
+		s->open_       = all;
+
+		std::uint64_t *path = &x.path_masks[s->index_ * x.words];
+		std::copy(&x.own_masks[s->index_ * x.words], &x.own_masks[s->index_ * x.words] + x.words, path);
+		if (auto *p = s->parent_) {
+			fill_path(p, done);
+			s->open_ = s->open_ || p->open_;
+			for (std::size_t w = 0; w < x.words; ++w) { path[w] |= x.path_masks[p->index_ * x.words + w]; }
+		}
+	}
+
+	static bool test_bit(const std::uint64_t *mask, std::size_t words, std::size_t type) {
+		return type / 64 < words && ((mask[type / 64] >> (type % 64)) & 1);
+	}
+
+	// Whether some state on the path from `s` to the root may handle `type`
+	bool accepted(const State<Traits> *s, std::size_t type) const {
+		const Extras &x = *extras_;
+		return type == any_type || s->open_ || test_bit(&x.path_masks[s->index_ * x.words], x.words, type);
+	}
+
+	// Whether any state in the machine may handle `type`
+	bool accepted_anywhere(std::size_t type) const {
+		const Extras &x = *extras_;
+		return type == any_type || x.any_open || test_bit(x.any_mask.data(), x.words, type);
+	}
+
+	static bool is_within(const State<Traits> *s, const State<Traits> *ancestor) {
+		while (s && s->depth_ > ancestor->depth_) { s = s->parent_; }
+		return s == ancestor;
+	}
+
+	// Take one token from every bucket that applies to `type` in the current state, or none if any is empty
+	bool admit(std::size_t type) {
+		Extras           &x       = *extras_;
+		bool              matched = false;
+		Clock::time_point now;
+		for (auto &l : x.limits) {
+			if (l.type != type || !is_within(active_state_, l.scope)) { continue; }
+			if (!matched) {
+				matched = true;
+				now     = Clock::now();
+			}
+			l.tokens = std::min(l.burst, l.tokens + std::chrono::duration<double>(now - l.last).count() * l.rate);
+			l.last   = now;
+			if (l.tokens < 1.0) { return false; }
+		}
+		if (matched) {
+			for (auto &l : x.limits) {
+				if (l.type == type && is_within(active_state_, l.scope)) { l.tokens -= 1.0; }
+			}
+		}
+		return true;
 	}
 
 	static State<Traits> *lca(State<Traits> *a, State<Traits> *b) {
@@ -313,7 +2009,8 @@ private:
 		return a;
 	}
 
-	void process_pending() {
+	// `watch` is the calling thread's watchdog slot, looked up once by the step or call that runs the transitions
+	void process_pending(WatchSlot *watch) {
 		static constexpr int MAX_TRANSITIONS = 100;
 
 		int count = 0;
@@ -325,20 +2022,30 @@ private:
 			auto *dest     = pending_state_;
 			has_pending_   = false;
 			pending_state_ = nullptr;
-			do_transition(dest);
+			settle(dest, watch);
 		}
 	}
 
-	void do_transition(State<Traits> *dest) {
+	// Run a transition and report where it left the machine
+	void settle(State<Traits> *dest, WatchSlot *watch) {
+		Writing writing(*this);
+		if (!extras_ || extras_->observers.empty()) { return do_transition(dest, watch); }
+		const State<Traits> *from = active_state_;
+		do_transition(dest, watch);
+		// A transition cut short by `stop()` never settled; observers already got `on_stop()`
+		if (is_terminated_) { return; }
+		for (auto *o : extras_->observers) { o->on_transition(*this, from, active_state_); }
+	}
+
+	void do_transition(State<Traits> *dest, WatchSlot *watch) {
 		auto *source = (phase_ == Phase::Entry && executing_state_) ? executing_state_ : active_state_;
 		if (!source) { source = &root_; }
 
 		if (source == dest) {
-			executing_state_ = source;
-			source->on_exit(*this);
+			leave(source, watch);
 			if (is_terminated_) { return; }
-			executing_state_ = dest;
-			dest->on_entry(*this);
+			enter(dest, watch);
+			if (!is_terminated_ && !has_pending_) { complete(dest); }
 			return;
 		}
 
@@ -346,13 +2053,12 @@ private:
 
 		phase_ = Phase::Exit;
 		for (auto *s = source; s != common; s = s->parent_) {
-			executing_state_ = s;
-			s->on_exit(*this);
+			leave(s, watch);
 			if (is_terminated_) {
 				phase_ = Phase::Idle;
 				return;
 			}
-			active_state_ = s->parent_;
+			activate(s->parent_);
 		}
 
 		if (dest != common) {
@@ -361,9 +2067,8 @@ private:
 			phase_  = Phase::Entry;
 			auto *s = common->path_next_;
 			while (s) {
-				executing_state_ = s;
-				s->on_entry(*this);
-				active_state_ = s;
+				enter(s, watch);
+				activate(s);
 
 				if (is_terminated_ || has_pending_) {
 					phase_ = Phase::Idle;
@@ -372,9 +2077,29 @@ private:
 				if (s == dest) { break; }
 				s = s->path_next_;
 			}
+			phase_ = Phase::Idle;
+			complete(dest);
+			return;
 		}
 		phase_ = Phase::Idle;
 	}
+
+	// Schedule the first completion transition of `s` whose guard holds
+	void complete(State<Traits> *s) {
+		if (!s->completes_) { return; }
+		const auto &completions = extras_->completions;
+		auto        it          = std::lower_bound(completions.begin(), completions.end(), s,
+													   [](const Completion &c, const State<Traits> *s) { return std::less<const State<Traits> *>()(c.from, s); });
+		for (; it != completions.end() && it->from == s; ++it) {
+			executing_state_ = s;
+			if (!it->guard || it->guard(*this)) {
+				pending_state_ = it->target;
+				has_pending_   = true;
+				return;
+			}
+			if (is_terminated_ || has_pending_) { return; }
+		}
+	}
 };
 
 // ============================================================================
@@ -398,6 +2123,28 @@ class Scope {
 			static_assert(std::is_same<void, decltype(fn(std::declval<Scope<Traits> &>()))>::value, "F must be callable as void(Scope<Traits>&)");
 			fn(sub_scope_);
 		}
+
+		ScopeProxy &targets(std::initializer_list<typename Traits::StateID> ids) {
+			sub_scope_.targets(ids);
+			return *this;
+		}
+
+		ScopeProxy &completion(typename Traits::StateID target, typename Machine<Traits>::Guard guard = nullptr) {
+			sub_scope_.completion(target, std::move(guard));
+			return *this;
+		}
+
+		template <typename... Es>
+		ScopeProxy &accepts() {
+			sub_scope_.template accepts<Es...>();
+			return *this;
+		}
+
+		template <typename E>
+		ScopeProxy &limit(double rate, double burst) {
+			sub_scope_.template limit<E>(rate, burst);
+			return *this;
+		}
 	};
 
 	// Lambda Proxy
@@ -412,6 +2159,10 @@ class Scope {
 			target_state_->handle_ = std::move(fn);
 			return *this;
 		}
+		LambdaProxy &query(typename LambdaState<Traits>::QueryFn fn) {
+			target_state_->query_ = std::move(fn);
+			return *this;
+		}
 		LambdaProxy &on_entry(typename LambdaState<Traits>::EntryFn fn) {
 			target_state_->entry_ = std::move(fn);
 			return *this;
@@ -424,6 +2175,24 @@ class Scope {
 			if (name) { target_state_->name_ = name; }
 			return *this;
 		}
+		LambdaProxy &targets(std::initializer_list<typename Traits::StateID> ids) {
+			ScopeProxy::targets(ids);
+			return *this;
+		}
+		LambdaProxy &completion(typename Traits::StateID target, typename Machine<Traits>::Guard guard = nullptr) {
+			ScopeProxy::completion(target, std::move(guard));
+			return *this;
+		}
+		template <typename... Es>
+		LambdaProxy &accepts() {
+			ScopeProxy::template accepts<Es...>();
+			return *this;
+		}
+		template <typename E>
+		LambdaProxy &limit(double rate, double burst) {
+			ScopeProxy::template limit<E>(rate, burst);
+			return *this;
+		}
 	};
 
 private:
@@ -432,30 +2201,86 @@ private:
 
 	Scope(Machine<Traits> *sm, State<Traits> *s) : machine_(sm), parent_(s) {}
 
+	// Checks states registered before this build or insertion; duplicates among new states are caught once they are sorted
 	bool has_state(typename Traits::StateID id) const {
-		for (const auto &pair : machine_->registry_) {
-			if (pair.first == id) { return true; }
-		}
-		return false;
+		const auto &registry = machine_->registry_;
+		const auto  sorted   = registry.begin() + static_cast<std::ptrdiff_t>(machine_->sorted_);
+
+		auto it = std::lower_bound(registry.begin(), sorted, id, [](const typename Machine<Traits>::Entry &entry, const typename Traits::StateID &val) {
+			return entry.first < val;
+		});
+		return it != sorted && it->first == id;
 	}
 
-	// Helper to register state pointer
-	void register_ptr(typename Traits::StateID id, State<Traits> *s) {
+	// Helper to register an owned state, returning its address
+	template <typename S>
+	S *register_ptr(typename Traits::StateID id, Owned<S> s) {
+		S *raw     = s.get();
 		s->parent_ = parent_;
 		s->depth_  = parent_->depth_ + 1;
 		s->id_     = id;
-		machine_->registry_.emplace_back(id, std::unique_ptr<State<Traits>>(s));
+		s->index_  = machine_->next_index_++;
+		machine_->registry_.emplace_back(id, std::move(s));
+		return raw;
 	}
 
 public:
+	/// @brief Declare every state this scope's state may transition to from its handlers and actions
+	/// @param ids Transition targets; may be empty, and repeated calls accumulate
+	/// @note Enables reachability analysis at `start()`. Class-based states and lambda states with callbacks
+	///       that declare nothing are assumed to reach any state.
+	void targets(std::initializer_list<typename Traits::StateID> ids) {
+		auto &edges         = machine_->extras().edges;
+		parent_->declared_  = true;
+		machine_->declared_ = true;
+		for (const auto &id : ids) { edges.emplace_back(parent_, id); }
+	}
+
+	/// @brief Declare the exact event types this scope's state handles
+	/// @tparam Es Static event types as passed to `dispatch`; may be empty
+	/// @note Once any state declares, events that no state on the active path accepts are dropped before queueing
+	///       or any virtual call and counted in `Stats::unhandleable`. Class-based states that declare nothing, and
+	///       lambda states with a handler, accept every type. Dispatching the base `Event` type is never filtered.
+	template <typename... Es>
+	void accepts() {
+		const std::size_t types[] = {detail::type_index<Es>()..., 0};
+		auto             &decl    = machine_->extras().accept_decl;
+		parent_->filters_         = true;
+		machine_->filtering_      = true;
+		for (std::size_t i = 0; i < sizeof...(Es); ++i) { decl.emplace_back(parent_, types[i]); }
+	}
+
+	/// @brief Declare a completion transition, taken as soon as this scope's state finishes its entry
+	/// @param target Destination state
+	/// @param guard Optional condition; the first declared completion whose guard holds is taken
+	/// @note Evaluated directly after the entry walk, without an event or the handler chain; guards should not
+	///       request transitions themselves. Also counts as a declared target for reachability analysis.
+	void completion(typename Traits::StateID target, typename Machine<Traits>::Guard guard = nullptr) {
+		if (parent_ == &machine_->root_) { throw std::logic_error("Root scope cannot have completion transitions"); }
+		parent_->completes_ = true;
+		auto &x = machine_->extras();
+		x.edges.emplace_back(parent_, target);
+		x.completions.push_back({parent_, target, nullptr, std::move(guard)});
+	}
+
+	/// @brief Declare a token bucket for events of static type `E` while the machine is inside this scope
+	/// @tparam E Event type as seen by `dispatch`; a root-scope limit applies machine-wide
+	/// @param rate Tokens refilled per second
+	/// @param burst Bucket capacity, also the initial token count
+	/// @note Over-limit events are dropped before any handler runs and counted in `Stats::rate_limited`
+	template <typename E>
+	void limit(double rate, double burst) {
+		if (rate < 0.0 || burst < 1.0) { throw std::invalid_argument("Invalid rate limit"); }
+		machine_->extras().limits.push_back({Machine<Traits>::template event_type<E>(), parent_, rate, burst, burst, Machine<Traits>::Clock::now()});
+	}
+
 	// Class-based (Template) -> ScopeProxy
 	template <typename S, typename... Args>
 	ScopeProxy state(typename Traits::StateID id, Args &&...args) {
 		static_assert(std::is_base_of<State<Traits>, S>::value, "Must derive from State");
 		if (has_state(id)) { throw std::invalid_argument("Duplicate StateID detected"); }
 
-		auto *s = new S(std::forward<Args>(args)...);
-		register_ptr(id, s);
+		auto *s = register_ptr(id, make_owned<S>(*machine_->resource_, std::forward<Args>(args)...));
 		return ScopeProxy(machine_, s);
 	}
 
@@ -463,8 +2288,7 @@ public:
 	LambdaProxy state(typename Traits::StateID id) {
 		if (has_state(id)) { throw std::invalid_argument("Duplicate StateID detected"); }
 
-		auto *s = new LambdaState<Traits>();
-		register_ptr(id, s);
+		auto *s = register_ptr(id, make_owned<LambdaState<Traits>>(*machine_->resource_));
 		return LambdaProxy(machine_, s);
 	}
 };
@@ -0,0 +1,144 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_HUGEPAGE_HPP
+#define HSM_HUGEPAGE_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "hsm.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+// Shared with store.hpp; either header may come first
+#ifndef HSM_HAS_MMAP
+#if defined(__unix__) || defined(__APPLE__)
+#define HSM_HAS_MMAP 1
+#else
+#define HSM_HAS_MMAP 0
+#endif
+#endif
+
+namespace hsm {
+
+// ============================================================================
+// Huge Page Resource
+// ============================================================================
+
+/// @brief Pool resource whose chunks are backed by huge pages where the platform allows
+/// @note Tries `MAP_HUGETLB`, then a regular mapping advised with `MADV_HUGEPAGE`, then plain pages.
+///       Not thread-safe: give each executor thread its own resource.
+class HugePageResource : public PoolResource {
+public:
+	enum class Backing {
+		None,         // Nothing mapped yet
+		HugeTlb,      // Explicit huge pages from the hugetlbfs pool
+		Transparent,  // Regular mapping advised for transparent huge pages
+		Regular,      // Base pages only
+	};
+
+	enum : std::size_t { huge_page_size = 2 * 1024 * 1024 };
+
+	/// @param chunk_bytes Size of each mapping, rounded up to `huge_page_size`
+	explicit HugePageResource(std::size_t chunk_bytes = 16 * huge_page_size) : chunk_bytes_(round_up(chunk_bytes)) {}
+
+	~HugePageResource() override {
+		for (const auto &c : chunks_) { unmap(c); }
+	}
+
+	HugePageResource(const HugePageResource &)            = delete;
+	HugePageResource &operator=(const HugePageResource &) = delete;
+
+	/// @brief How the most recent chunk is backed
+	Backing backing() const { return chunks_.empty() ? Backing::None : chunks_.back().backing; }
+
+	/// @brief Total bytes mapped so far
+	std::size_t mapped() const {
+		std::size_t total = 0;
+		for (const auto &c : chunks_) { total += c.bytes; }
+		return total;
+	}
+
+protected:
+	void *refill(std::size_t min_bytes, std::size_t &got) override {
+		Chunk c;
+		c.bytes = round_up(min_bytes > chunk_bytes_ ? min_bytes : chunk_bytes_);
+		c.addr  = map(c.bytes, c.backing);
+		if (!c.addr) { return nullptr; }
+		chunks_.push_back(c);
+		got = c.bytes;
+		return c.addr;
+	}
+
+private:
+	struct Chunk {
+		void       *addr    = nullptr;
+		std::size_t bytes   = 0;
+		Backing     backing = Backing::None;
+	};
+
+	std::size_t        chunk_bytes_;
+	std::vector<Chunk> chunks_;
+
+	static std::size_t round_up(std::size_t n) { return (n + huge_page_size - 1) / huge_page_size * huge_page_size; }
+
+	static void *map(std::size_t bytes, Backing &backing) {
+#if HSM_HAS_MMAP
+#ifdef MAP_HUGETLB
+		void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p != MAP_FAILED) {
+			backing = Backing::HugeTlb;
+			return p;
+		}
+#endif
+		void *q = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (q == MAP_FAILED) { return nullptr; }
+		backing = Backing::Regular;
+#ifdef MADV_HUGEPAGE
+		if (madvise(q, bytes, MADV_HUGEPAGE) == 0) { backing = Backing::Transparent; }
+#endif
+		return q;
+#else
+		backing = Backing::Regular;
+		return ::operator new(bytes, std::nothrow);
+#endif
+	}
+
+	static void unmap(const Chunk &c) {
+#if HSM_HAS_MMAP
+		munmap(c.addr, c.bytes);
+#else
+		::operator delete(c.addr);
+#endif
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_HUGEPAGE_HPP
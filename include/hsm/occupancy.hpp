@@ -0,0 +1,246 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_OCCUPANCY_HPP
+#define HSM_OCCUPANCY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <stdexcept>
+#include <vector>
+
+#include "hsm.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// Occupancy Index
+// ============================================================================
+
+/// @brief Fleet-wide count and membership of machines per active state, updated on every transition
+/// @note States are keyed by `State::index()`, so every tracked machine must declare the same tree in the same
+///       order. A machine counts toward every state on its active path, so a composite state's count includes the
+///       machines in any of its substates; the root is not counted, `size()` covers it. A machine that stops leaves
+///       every count until it is started again. Not thread-safe: track machines driven by the thread that
+///       queries the index.
+template <typename Traits>
+class OccupancyIndex {
+	using StateID = typename Traits::StateID;
+
+	struct Node;
+
+public:
+	/// @brief Tracked machine
+	using Handle = Node *;
+
+	OccupancyIndex() = default;
+
+	OccupancyIndex(const OccupancyIndex &)            = delete;
+	OccupancyIndex &operator=(const OccupancyIndex &) = delete;
+
+	/// @brief Start tracking a running machine
+	/// @throws std::logic_error If the machine is not started or already terminated, or is dispatching; the
+	///         index is left unchanged
+	/// @note Pass the handle to `untrack()` before the machine is destroyed
+	Handle track(Machine<Traits> &sm) {
+		const State<Traits> *s = sm.current_state();
+		if (!s || !sm.started() || sm.terminated()) { throw std::logic_error("Cannot track a machine that is not started"); }
+
+		Node *n = free_;
+		if (n) {
+			free_ = n->free;
+		} else {
+			nodes_.emplace_back();
+			n = &nodes_.back();
+		}
+		n->owner   = this;
+		n->machine = &sm;
+		n->stopped = false;
+		n->path.clear();
+		// Linked only once the machine reports to it, so a refused registration leaves no trace
+		bool observed = false;
+		try {
+			sm.observe(*n);
+			observed = true;
+			move(n, s);
+		} catch (...) {
+			if (observed) { sm.unobserve(*n); }
+			recycle(n);
+			throw;
+		}
+		++tracked_;
+		return n;
+	}
+
+	/// @brief Stop tracking a machine
+	void untrack(Handle n) {
+		n->machine->unobserve(*n);
+		if (!n->stopped) { --tracked_; }
+		recycle(n);
+	}
+
+	/// @brief Machines currently tracked and running
+	std::size_t size() const { return tracked_; }
+
+	/// @brief Machines with state `index` on their active path, in O(1)
+	std::size_t count_index(std::uint32_t index) const { return index < counts_.size() ? counts_[index] : 0; }
+
+	/// @brief Machines with `ref` on their active path, in O(1)
+	std::size_t count(StateRef ref) const { return count_index(ref.index); }
+
+	/// @brief Machines with `id` on their active path, in O(log #states)
+	std::size_t count(StateID id) const {
+		const std::uint32_t index = lookup(id);
+		return index == npos ? 0 : counts_[index];
+	}
+
+	/// @brief Machine counts indexed by `State::index()`, in O(#states)
+	const std::vector<std::size_t> &histogram() const { return counts_; }
+
+	/// @brief Call `fn(Machine&)` for every machine with `ref` on its active path, in O(result)
+	template <typename F>
+	void for_each(StateRef ref, F &&fn) const {
+		if (ref.index >= heads_.size()) { return; }
+		const std::uint32_t level = depths_[ref.index];
+		for (Node *n = heads_[ref.index]; n;) {
+			Node *next = n->path[level].next;
+			fn(*n->machine);
+			n = next;
+		}
+	}
+
+	/// @brief Call `fn(Machine&)` for every machine with `id` on its active path, in O(log #states + result)
+	template <typename F>
+	void for_each(StateID id, F &&fn) const {
+		const std::uint32_t index = lookup(id);
+		if (index != npos) { for_each(StateRef(index), std::forward<F>(fn)); }
+	}
+
+private:
+	enum : std::uint32_t { npos = 0xFFFFFFFFu };
+
+	// Membership of one machine in the list of the state at one depth of its active path
+	struct Link {
+		std::uint32_t state;
+		Node         *prev;
+		Node         *next;
+	};
+
+	struct Node : Observer<Traits> {
+		OccupancyIndex   *owner   = nullptr;
+		Machine<Traits>  *machine = nullptr;
+		Node             *free    = nullptr;  // Next unused node while on the free list
+		bool              stopped = false;    // Terminated since tracked; counted nowhere until restarted
+		std::vector<Link> path;               // Active path below the root, outermost first
+
+		void on_transition(const Machine<Traits> &, const State<Traits> *, const State<Traits> *to) override {
+			if (stopped) {
+				stopped = false;
+				++owner->tracked_;
+			}
+			owner->move(this, to);
+		}
+		void on_stop(const Machine<Traits> &) override {
+			owner->truncate(this, 0);
+			stopped = true;
+			--owner->tracked_;
+		}
+	};
+
+	std::deque<Node>                               nodes_;
+	Node                                          *free_ = nullptr;
+	std::vector<Node *>                            heads_;    // Intrusive membership list per state index
+	std::vector<std::size_t>                       counts_;   // Machines per state index
+	std::vector<std::uint32_t>                     depths_;   // Position in `Node::path` per state index
+	std::vector<std::pair<StateID, std::uint32_t>> ids_;      // State index per ID, sorted by ID, as first seen
+	std::vector<const State<Traits> *>             scratch_;  // Active path being entered, innermost first
+	std::size_t                                    tracked_ = 0;
+
+	static bool by_id(const std::pair<StateID, std::uint32_t> &entry, const StateID &id) { return entry.first < id; }
+
+	std::uint32_t lookup(const StateID &id) const {
+		auto it = std::lower_bound(ids_.begin(), ids_.end(), id, by_id);
+		return it != ids_.end() && it->first == id ? it->second : npos;
+	}
+
+	// Re-link `n` under the active path ending at `s`, touching only the levels that changed
+	void move(Node *n, const State<Traits> *s) {
+		scratch_.clear();
+		for (; s && s->parent(); s = s->parent()) { scratch_.push_back(s); }
+
+		const std::size_t depth = scratch_.size();
+		std::size_t       keep  = 0;
+		while (keep < depth && keep < n->path.size() && n->path[keep].state == scratch_[depth - 1 - keep]->index()) { ++keep; }
+		truncate(n, keep);
+		for (std::size_t level = keep; level < depth; ++level) { enter(n, scratch_[depth - 1 - level]); }
+	}
+
+	void enter(Node *n, const State<Traits> *s) {
+		const std::uint32_t index = s->index();
+		if (index >= heads_.size()) {
+			heads_.resize(index + 1, nullptr);
+			counts_.resize(index + 1, 0);
+			depths_.resize(index + 1, npos);
+		}
+		if (depths_[index] == npos) {
+			depths_[index] = static_cast<std::uint32_t>(n->path.size());
+			auto it        = std::lower_bound(ids_.begin(), ids_.end(), s->id(), by_id);
+			if (it == ids_.end() || !(it->first == s->id())) { ids_.emplace(it, s->id(), index); }
+		}
+		n->path.push_back(Link{index, nullptr, heads_[index]});
+		if (heads_[index]) { heads_[index]->path[depths_[index]].prev = n; }
+		heads_[index] = n;
+		++counts_[index];
+	}
+
+	void recycle(Node *n) {
+		truncate(n, 0);
+		n->machine = nullptr;
+		n->free    = free_;
+		free_      = n;
+	}
+
+	// Leave every state below the first `keep` levels of the path, innermost first
+	void truncate(Node *n, std::size_t keep) {
+		while (n->path.size() > keep) {
+			const Link         &link  = n->path.back();
+			const std::uint32_t level = depths_[link.state];
+			if (link.prev) {
+				link.prev->path[level].next = link.next;
+			} else {
+				heads_[link.state] = link.next;
+			}
+			if (link.next) { link.next->path[level].prev = link.prev; }
+			--counts_[link.state];
+			n->path.pop_back();
+		}
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_OCCUPANCY_HPP
@@ -0,0 +1,151 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_SNAPSHOT_HPP
+#define HSM_SNAPSHOT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include "hsm.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// Snapshot Publisher
+// ============================================================================
+
+/// @brief Buffered copy of selected machine fields, refreshed after every run-to-completion step
+/// @tparam Snapshot Default-constructible, user-declared view of the context; buffers are reused, so members such
+///         as strings keep their capacity between steps
+/// @note Readers go through a `Reader` each, which pins the buffer it last read. With `readers + 2` buffers the
+///       owner always finds one that is neither pinned nor the latest, so publishing never blocks; reading is
+///       lock-free and only retries when the owner reclaimed the buffer it was about to pin. Destroy every
+///       `Reader` before the publisher and the publisher before the machine.
+template <typename Traits, typename Snapshot>
+class SnapshotPublisher : public Observer<Traits> {
+public:
+	using Fill = std::function<void(const Machine<Traits> &, Snapshot &)>;
+
+	/// @param sm Machine to observe; its current state is published right away
+	/// @param fill Copies the fields of interest into a snapshot buffer, on the owner thread
+	/// @param readers Most `Reader`s that may exist at once
+	SnapshotPublisher(Machine<Traits> &sm, Fill fill, std::size_t readers = 1)
+		: sm_(&sm), fill_(std::move(fill)), slots_(new Slot[readers + 2]), count_(readers + 2), readers_(readers) {
+		publish();
+		sm_->observe(*this);
+	}
+
+	~SnapshotPublisher() override { sm_->unobserve(*this); }
+
+	SnapshotPublisher(const SnapshotPublisher &)            = delete;
+	SnapshotPublisher &operator=(const SnapshotPublisher &) = delete;
+
+	/// @brief Handle for one reading thread
+	class Reader {
+	public:
+		/// @throws std::logic_error If the publisher already has as many readers as it was built for
+		explicit Reader(SnapshotPublisher &publisher) : publisher_(&publisher) {
+			if (publisher.attached_.fetch_add(1, std::memory_order_relaxed) >= publisher.readers_) {
+				publisher.attached_.fetch_sub(1, std::memory_order_relaxed);
+				throw std::logic_error("Too many snapshot readers");
+			}
+		}
+
+		~Reader() {
+			if (held_ != none) { publisher_->slots_[held_].pins.fetch_sub(1, std::memory_order_release); }
+			publisher_->attached_.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		Reader(const Reader &)            = delete;
+		Reader &operator=(const Reader &) = delete;
+
+		/// @brief Latest published snapshot; stays valid and unchanged until this reader's next `read()`
+		const Snapshot &read() {
+			std::size_t latest = publisher_->latest_.load(std::memory_order_acquire);
+			if (latest == held_) { return publisher_->slots_[latest].value; }
+			if (held_ != none) { publisher_->slots_[held_].pins.fetch_sub(1, std::memory_order_release); }
+			for (;; latest = publisher_->latest_.load(std::memory_order_acquire)) {
+				std::atomic<std::uint32_t> &pins = publisher_->slots_[latest].pins;
+				std::uint32_t               seen = pins.load(std::memory_order_relaxed);
+				if (!(seen & writing) && pins.compare_exchange_weak(seen, seen + 1, std::memory_order_acquire, std::memory_order_relaxed)) { break; }
+			}
+			held_ = latest;
+			return publisher_->slots_[latest].value;
+		}
+
+	private:
+		enum : std::size_t { none = static_cast<std::size_t>(-1) };
+
+		SnapshotPublisher *publisher_;
+		std::size_t        held_ = none;  // Pinned buffer
+	};
+
+	/// @brief Publish outside a step, e.g. after `transition()` was called while idle
+	/// @note Owner thread only
+	void publish() {
+		// A free buffer exists: at most `readers_` are pinned and one is the latest
+		const std::size_t latest = latest_.load(std::memory_order_relaxed);
+		for (;; next_ = next_ + 1 == count_ ? 0 : next_ + 1) {
+			std::uint32_t idle = 0;
+			if (next_ != latest && slots_[next_].pins.compare_exchange_strong(idle, writing, std::memory_order_acquire, std::memory_order_relaxed)) { break; }
+		}
+		Slot &slot = slots_[next_];
+		fill_(*sm_, slot.value);
+		slot.pins.store(0, std::memory_order_release);
+		latest_.store(next_, std::memory_order_release);
+		published_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// @brief Snapshots published so far
+	std::uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+
+	void on_step(const Machine<Traits> &) override { publish(); }
+
+private:
+	enum : std::uint32_t { writing = 0x80000000u };
+
+	struct Slot {
+		Snapshot                   value;
+		std::atomic<std::uint32_t> pins{0};  // Readers holding the buffer, or `writing` while the owner fills it
+	};
+
+	Machine<Traits>           *sm_;
+	Fill                       fill_;
+	std::unique_ptr<Slot[]>    slots_;
+	std::size_t                count_;
+	std::size_t                readers_;
+	std::size_t                next_ = 0;  // Owner only: where the search for a free buffer starts
+	std::atomic<std::size_t>   latest_{0};
+	std::atomic<std::size_t>   attached_{0};
+	std::atomic<std::uint64_t> published_{0};
+};
+
+}  // namespace hsm
+
+#endif  // HSM_SNAPSHOT_HPP
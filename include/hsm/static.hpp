@@ -0,0 +1,104 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_STATIC_HPP
+#define HSM_STATIC_HPP
+
+#include <cstddef>
+#include <new>
+
+#include "hsm.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// Static Resource
+// ============================================================================
+
+/// @brief Pool resource over a fixed buffer held inline, for targets without a heap after init
+/// @tparam Bytes Capacity; requests beyond it, or larger than `max_block`, throw `std::bad_alloc`
+/// @note Never falls back to `default_resource()`. Freed blocks are reused per size class.
+template <std::size_t Bytes>
+class StaticResource : public PoolResource {
+public:
+	StaticResource() = default;
+
+	StaticResource(const StaticResource &)            = delete;
+	StaticResource &operator=(const StaticResource &) = delete;
+
+	void *allocate(std::size_t bytes, std::size_t align) override {
+		if (bytes > max_block || align > alignment) { throw std::bad_alloc(); }
+		return PoolResource::allocate(bytes, align);
+	}
+
+	/// @brief High-water mark of the buffer, for sizing `Bytes`; blocks freed and reused are counted once
+	std::size_t used() const { return given_ ? Bytes - remaining() : 0; }
+
+protected:
+	void *refill(std::size_t min_bytes, std::size_t &got) override {
+		if (given_ || min_bytes > Bytes) { return nullptr; }
+		given_ = true;
+		got    = Bytes;
+		return buffer_;
+	}
+
+private:
+	alignas(alignment) unsigned char buffer_[Bytes];
+	bool given_ = false;
+};
+
+// ============================================================================
+// Static Machine
+// ============================================================================
+
+namespace detail {
+
+// Base class so the storage is constructed before, and destroyed after, the machine using it
+template <std::size_t Bytes>
+struct StaticStorage {
+	StaticResource<Bytes> storage;
+};
+
+}  // namespace detail
+
+/// @brief Machine whose states, registry and event queue live in a buffer embedded in the object
+/// @tparam Bytes Arena capacity shared by state objects, the registry and the dispatch queue
+/// @note Declare it with static storage duration and nothing in `start()`, `dispatch()` or `transition()`
+///       touches the heap, as long as handlers are function pointers or captureless lambdas, state names fit
+///       the small-string buffer, and neither `post()`, `observe()` nor the `Scope::accepts`, `limit`,
+///       `targets` and `completion` declarations are used. Running out of arena throws `std::bad_alloc`.
+template <typename Traits, std::size_t Bytes>
+class StaticMachine : private detail::StaticStorage<Bytes>, public Machine<Traits> {
+public:
+	template <typename... Args>
+	explicit StaticMachine(Args &&...args) : Machine<Traits>(WithResource(this->storage), std::forward<Args>(args)...) {}
+
+	/// @brief Arena the machine allocates from
+	const StaticResource<Bytes> &arena() const { return this->storage; }
+};
+
+}  // namespace hsm
+
+#endif  // HSM_STATIC_HPP
@@ -0,0 +1,261 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_STORE_HPP
+#define HSM_STORE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "hsm.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Shared with hugepage.hpp; either header may come first
+#ifndef HSM_HAS_MMAP
+#if defined(__unix__) || defined(__APPLE__)
+#define HSM_HAS_MMAP 1
+#else
+#define HSM_HAS_MMAP 0
+#endif
+#endif
+
+namespace hsm {
+
+// ============================================================================
+// Fleet Store
+// ============================================================================
+
+/// @brief File-backed table of machine cores that survives process restarts
+/// @note Each slot holds the active `State::index()`, run flags and the machine's context at a fixed offset, kept
+///       current by a per-slot observer. After a restart, `resume()` rebuilds the tree and points the machine at
+///       its slot without deserializing or running entry actions. Requires `ExternalContext` and a trivially
+///       copyable context; the state tree must be declared identically across runs.
+template <typename Traits>
+class FleetStore {
+	using Context = typename Traits::Context;
+	using StateID = typename Traits::StateID;
+
+	static_assert(std::is_same<typename detail::context_storage<Traits>::type, ExternalContext>::value, "Traits::ContextStorage must be ExternalContext");
+	static_assert(std::is_trivially_copyable<Context>::value, "Traits::Context must be trivially copyable");
+
+public:
+	/// @brief Open `path`, creating a store with room for `capacity` machines if it does not exist
+	/// @throws std::runtime_error If the file cannot be mapped or was written for a different record layout
+	FleetStore(const std::string &path, std::size_t capacity) {
+#if HSM_HAS_MMAP
+		const int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0) { throw std::runtime_error("Cannot open fleet store"); }
+		struct stat st;
+		if (::fstat(fd, &st) != 0) {
+			::close(fd);
+			throw std::runtime_error("Cannot open fleet store");
+		}
+
+		const bool fresh = st.st_size == 0;
+		if (!fresh) {
+			Header h;
+			if (::pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)) || std::memcmp(h.magic, magic(), sizeof(h.magic)) != 0 ||
+				h.record_size != sizeof(Record)) {
+				::close(fd);
+				throw std::runtime_error("Fleet store layout mismatch");
+			}
+			// Every record must lie inside the file; mapping past the end of a truncated one faults on first access
+			const std::uint64_t size = static_cast<std::uint64_t>(st.st_size);
+			if (size < records_offset || h.capacity > (size - records_offset) / sizeof(Record)) {
+				::close(fd);
+				throw std::runtime_error("Fleet store layout mismatch");
+			}
+			capacity = static_cast<std::size_t>(h.capacity);
+		}
+		bytes_ = records_offset + capacity * sizeof(Record);
+		if (fresh && ::ftruncate(fd, static_cast<off_t>(bytes_)) != 0) {
+			::close(fd);
+			throw std::runtime_error("Cannot size fleet store");
+		}
+		void *p = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED) { throw std::runtime_error("Cannot map fleet store"); }
+		base_ = static_cast<char *>(p);
+		if (fresh) {
+			Header *h = header();
+			std::memcpy(h->magic, magic(), sizeof(h->magic));
+			h->record_size = sizeof(Record);
+			h->capacity    = capacity;
+		}
+		capacity_ = capacity;
+		bindings_.reset(new Binding[capacity]);
+		for (std::size_t i = 0; i < capacity; ++i) { bindings_[i].record = record(i); }
+#else
+		(void)path;
+		(void)capacity;
+		throw std::runtime_error("Fleet store requires mmap");
+#endif
+	}
+
+	~FleetStore() {
+#if HSM_HAS_MMAP
+		if (base_) { ::munmap(base_, bytes_); }
+#endif
+	}
+
+	FleetStore(const FleetStore &)            = delete;
+	FleetStore &operator=(const FleetStore &) = delete;
+
+	std::size_t capacity() const { return capacity_; }
+
+	/// @brief Context stored in `slot`; construct the slot's machine with it
+	Context &context(std::size_t slot) { return record(checked(slot))->context; }
+
+	/// @brief Whether `slot` holds a machine that was started and not released
+	bool in_use(std::size_t slot) const { return record(checked(slot))->flags & started; }
+
+	/// @brief Start `sm` fresh in `slot`, value-initializing the stored context
+	/// @throws std::logic_error If `sm` is running; nothing is changed
+	/// @note `sm` keeps its context in the store's mapping, so it must be destroyed before the store or detached
+	///       with `release()`. If `sm.start()` throws, the slot's previous record and the machine's previous
+	///       context are restored.
+	template <class F>
+	void start(Machine<Traits> &sm, std::size_t slot, StateID initial_id, F &&fn) {
+		Record *r = record(checked(slot));
+		if (sm.started() && !sm.terminated()) { throw std::logic_error("Cannot already started"); }
+		const Record saved(*r);
+		Context     &previous = sm.context();
+		new (&r->context) Context();
+		r->flags = 0;
+		bind(sm, slot);
+		try {
+			sm.start(initial_id, std::forward<F>(fn));
+		} catch (...) {
+			unbind(sm, slot, previous);
+			*r = saved;
+			throw;
+		}
+		r->flags |= started;
+	}
+
+	/// @brief Reattach `sm` to the core recorded in `slot` by a previous process
+	/// @throws std::logic_error If the slot is not in use or `sm` is running
+	/// @note If `sm.resume()` throws, the machine's previous context is restored and the slot is left alone
+	template <class F>
+	void resume(Machine<Traits> &sm, std::size_t slot, F &&fn) {
+		Record *r = record(checked(slot));
+		if (!(r->flags & started)) { throw std::logic_error("Fleet store slot is not in use"); }
+		if (sm.started() && !sm.terminated()) { throw std::logic_error("Cannot already started"); }
+		Context &previous = sm.context();
+		bind(sm, slot);
+		try {
+			sm.resume(r->state, std::forward<F>(fn));
+		} catch (...) {
+			unbind(sm, slot, previous);
+			throw;
+		}
+		if (r->flags & terminated) { sm.stop(); }
+	}
+
+	/// @brief Detach `sm` from `slot` and mark the slot free
+	/// @param into Receives the slot's context; `sm` is rebound to it so it no longer points into the store
+	void release(Machine<Traits> &sm, std::size_t slot, Context &into) {
+		Record *r = record(checked(slot));
+		sm.unobserve(bindings_[slot]);
+		into = r->context;
+		sm.rebind_context(into);
+		r->flags = 0;
+	}
+
+	/// @brief Flush dirty pages to the file
+	void sync() {
+#if HSM_HAS_MMAP
+		::msync(base_, bytes_, MS_SYNC);
+#endif
+	}
+
+private:
+	enum : std::uint32_t { started = 1, terminated = 2 };
+	enum : std::size_t { records_offset = 64 };
+
+	struct Header {
+		char          magic[8];
+		std::uint32_t record_size;
+		std::uint32_t reserved;
+		std::uint64_t capacity;
+	};
+
+	struct Record {
+		std::uint32_t state;
+		std::uint32_t flags;
+		Context       context;
+	};
+
+	// Writes the settled state and termination through to the record, whoever calls `stop()`
+	struct Binding : Observer<Traits> {
+		Record *record = nullptr;
+
+		void on_transition(const Machine<Traits> &, const State<Traits> *, const State<Traits> *to) override { record->state = to->index(); }
+		void on_stop(const Machine<Traits> &) override { record->flags |= terminated; }
+	};
+
+	char                      *base_     = nullptr;
+	std::size_t                bytes_    = 0;
+	std::size_t                capacity_ = 0;
+	std::unique_ptr<Binding[]> bindings_;
+
+	static const char *magic() { return "HSMFLEET"; }
+
+	Header       *header() { return reinterpret_cast<Header *>(base_); }
+	Record       *record(std::size_t slot) { return reinterpret_cast<Record *>(base_ + records_offset) + slot; }
+	const Record *record(std::size_t slot) const { return reinterpret_cast<const Record *>(base_ + records_offset) + slot; }
+
+	std::size_t checked(std::size_t slot) const {
+		if (slot >= capacity_) { throw std::invalid_argument("Fleet store slot out of range"); }
+		return slot;
+	}
+
+	void bind(Machine<Traits> &sm, std::size_t slot) {
+		sm.rebind_context(record(slot)->context);
+		sm.unobserve(bindings_[slot]);
+		sm.observe(bindings_[slot]);
+	}
+
+	// Undo `bind()` after a failed start or resume
+	void unbind(Machine<Traits> &sm, std::size_t slot, Context &previous) {
+		sm.unobserve(bindings_[slot]);
+		sm.rebind_context(previous);
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_STORE_HPP
@@ -0,0 +1,412 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_TIMER_HPP
+#define HSM_TIMER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "hsm.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// Timer Wheel
+// ============================================================================
+
+/// @brief Timer set for many machines, where each timer fires anywhere inside its own [earliest, latest] window
+/// @note Each timer is placed on the coarsest tick boundary inside its window, so timers with overlapping
+///       windows share one bucket and fire in one batch. Buckets sit in a hierarchical wheel of 64-slot levels,
+///       so arming and cancelling take constant time and a bucket moves down at most once per level before it
+///       fires. Not thread-safe: drive it from the thread that owns the machines it dispatches to.
+class TimerWheel {
+public:
+	using Clock     = std::chrono::steady_clock;
+	using TimePoint = Clock::time_point;
+	using Callback  = std::function<void()>;
+
+	/// @brief Cancellation handle; stays harmless after the timer fired or its slot was reused
+	struct Handle {
+		std::uint32_t index      = 0;
+		std::uint32_t generation = 0;
+
+		Handle() = default;
+		Handle(std::uint32_t index, std::uint32_t generation) : index(index), generation(generation) {}
+	};
+
+	/// @param resolution Width of one tick; no deadline is finer than this
+	/// @param resource Backend for the bucket index
+	/// @throws std::invalid_argument If the resolution is not positive
+	explicit TimerWheel(Clock::duration resolution = std::chrono::milliseconds(1), MemoryResource &resource = *default_resource())
+		: resolution_(resolution), buckets_(0, Buckets::hasher(), Buckets::key_equal(), Buckets::allocator_type(&resource)) {
+		if (resolution_ <= Clock::duration::zero()) { throw std::invalid_argument("Timer resolution must be positive"); }
+	}
+
+	TimerWheel(const TimerWheel &)            = delete;
+	TimerWheel &operator=(const TimerWheel &) = delete;
+
+	/// @brief Arm a timer that may fire at any point from `earliest` to `latest`
+	/// @return Handle for `cancel()`
+	/// @note A window narrower than one tick fires on the first tick at or after `earliest`; one that already
+	///       passed fires on the next `advance()`
+	Handle schedule(TimePoint earliest, TimePoint latest, Callback callback) {
+		const std::int64_t first = ceil_tick(earliest);
+		std::int64_t       last  = floor_tick(latest);
+		if (last < first) { last = first; }
+
+		// Largest power-of-two tick multiple not after `last` that is still inside the window
+		std::int64_t step = 1;
+		while (step < (std::int64_t(1) << 40) && floor_to(last, step * 2) >= first) { step *= 2; }
+
+		const std::uint32_t index = acquire();
+		Node               &n     = nodes_[index];
+		n.deadline                = std::max(floor_to(last, step), now_);
+		n.callback                = std::move(callback);
+		link(index, bucket(n.deadline).head);
+		++armed_;
+		return Handle{index, n.generation};
+	}
+
+	/// @brief Arm a timer firing `delay` after now, with up to `slack` extra latency
+	Handle schedule(Clock::duration delay, Clock::duration slack, Callback callback) {
+		const TimePoint now = Clock::now();
+		return schedule(now + delay, now + delay + slack, std::move(callback));
+	}
+
+	/// @brief Arm a timer that dispatches `evt` to `sm`
+	template <typename Traits, typename E>
+	Handle schedule_dispatch(Machine<Traits> &sm, TimePoint earliest, TimePoint latest, const E &evt) {
+		return schedule(earliest, latest, [&sm, evt] { sm.dispatch(evt); });
+	}
+
+	/// @brief Disarm a timer
+	/// @return False if it already fired or was cancelled
+	bool cancel(Handle h) {
+		if (h.index >= nodes_.size()) { return false; }
+		Node &n = nodes_[h.index];
+		if (n.generation != h.generation || !n.armed) { return false; }
+		if (n.firing) {
+			unlink(h.index, firing_);
+		} else {
+			auto it = buckets_.find(n.deadline);
+			unlink(h.index, it->second.head);
+			if (it->second.head == npos) { drop(it); }
+		}
+		release(h.index);
+		--armed_;
+		return true;
+	}
+
+	/// @brief Fire every timer due at `now`, bucket by bucket in deadline order
+	/// @return Number of callbacks invoked
+	/// @note Callbacks may schedule and cancel timers; ones due at `now` fire in the same call. An exception from a
+	///       callback propagates after the rest of its bucket is put back, armed, for the next call.
+	std::size_t advance(TimePoint now = Clock::now()) {
+		const std::int64_t tick  = floor_tick(now);
+		std::size_t        fired = 0;
+		unsigned           level = 0;
+		unsigned           slot  = 0;
+		std::int64_t       start = 0;
+		next_known_              = false;
+		while (next_slot(level, slot, start) && start <= tick) {
+			now_ = start;
+
+			Bucket *b           = slots_[level][slot];
+			slots_[level][slot] = nullptr;
+			occupied_[level] &= ~(std::uint64_t(1) << slot);
+
+			if (level > 0) {
+				// Everything in a coarse slot now lies within a finer level
+				while (b) {
+					Bucket *next = b->next;
+					place(*b);
+					b = next;
+				}
+				continue;
+			}
+
+			// A level-0 slot is a single tick, so it holds exactly the bucket due now
+			firing_ = b->head;
+			buckets_.erase(b->deadline);
+			for (std::uint32_t i = firing_; i != npos; i = nodes_[i].next) { nodes_[i].firing = true; }
+			++buckets_fired_;
+
+			while (firing_ != npos) {
+				const std::uint32_t index = firing_;
+				unlink(index, firing_);
+				Callback callback = std::move(nodes_[index].callback);
+				release(index);
+				--armed_;
+				++fired;
+				try {
+					callback();
+				} catch (...) {
+					requeue_firing();
+					++wakeups_;
+					fired_ += fired;
+					throw;
+				}
+			}
+		}
+		if (tick > now_) { now_ = tick; }
+		if (fired) { ++wakeups_; }
+		fired_ += fired;
+		return fired;
+	}
+
+	/// @brief When the next bucket is due, or `TimePoint::max()` if nothing is armed
+	TimePoint next_wakeup() const {
+		if (!next_known_) {
+			next_       = earliest();
+			next_known_ = true;
+		}
+		if (next_ == never) { return TimePoint::max(); }
+		return TimePoint(resolution_ * next_);
+	}
+
+	/// @brief Timers currently armed
+	std::size_t size() const { return armed_; }
+
+	/// @brief Distinct deadlines currently armed
+	std::size_t buckets() const { return buckets_.size(); }
+
+	/// @brief Calls to `advance()` that fired at least one timer
+	std::uint64_t wakeups() const { return wakeups_; }
+
+	/// @brief Buckets fired so far
+	std::uint64_t buckets_fired() const { return buckets_fired_; }
+
+	/// @brief Callbacks invoked so far
+	std::uint64_t fired() const { return fired_; }
+
+private:
+	enum : std::uint32_t { npos = 0xFFFFFFFFu };
+	enum : unsigned { SLOT_BITS = 6, SLOTS = 1u << SLOT_BITS, LEVELS = (64 + SLOT_BITS - 1) / SLOT_BITS };
+
+	static constexpr std::int64_t never = std::numeric_limits<std::int64_t>::max();
+
+	struct Node {
+		std::int64_t  deadline   = 0;
+		std::uint32_t prev       = npos;
+		std::uint32_t next       = npos;
+		std::uint32_t generation = 0;
+		bool          armed      = false;
+		bool          firing     = false;
+		Callback      callback;
+	};
+
+	// Timers sharing one deadline, linked into the wheel slot that currently holds that deadline
+	struct Bucket {
+		std::int64_t  deadline = 0;
+		std::uint32_t head     = npos;
+		Bucket       *prev     = nullptr;
+		Bucket       *next     = nullptr;
+		unsigned      level    = 0;
+		unsigned      slot     = 0;
+	};
+
+	using Entry   = std::pair<const std::int64_t, Bucket>;
+	using Buckets = std::unordered_map<std::int64_t, Bucket, std::hash<std::int64_t>, std::equal_to<std::int64_t>, ResourceAllocator<Entry>>;
+
+	Clock::duration      resolution_;
+	Buckets              buckets_;                  // Deadline tick -> its bucket; entries never move once inserted
+	Bucket              *slots_[LEVELS][SLOTS] = {};  // Level k slot s: deadlines agreeing with `now_` above level k
+	std::uint64_t        occupied_[LEVELS]     = {};  // Bit per non-empty slot
+	std::int64_t         now_                  = 0;   // Tick the wheel has advanced to
+	std::vector<Node>    nodes_;
+	std::uint32_t        free_          = npos;
+	std::uint32_t        firing_        = npos;  // Detached list of the bucket being fired
+	std::size_t          armed_         = 0;
+	std::uint64_t        wakeups_       = 0;
+	std::uint64_t        buckets_fired_ = 0;
+	std::uint64_t        fired_         = 0;
+	mutable std::int64_t next_          = never;  // Cached earliest deadline, valid while `next_known_`
+	mutable bool         next_known_    = true;
+
+	static unsigned top_bit(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+		return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#else
+		unsigned bit = 0;
+		while (v >>= 1) { ++bit; }
+		return bit;
+#endif
+	}
+
+	static unsigned low_bit(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<unsigned>(__builtin_ctzll(v));
+#else
+		unsigned bit = 0;
+		for (; !(v & 1); v >>= 1) { ++bit; }
+		return bit;
+#endif
+	}
+
+	static std::int64_t floor_to(std::int64_t tick, std::int64_t step) {
+		const std::int64_t q = tick / step;
+		return (q * step > tick ? q - 1 : q) * step;
+	}
+
+	std::int64_t floor_tick(TimePoint t) const { return floor_to(t.time_since_epoch().count(), resolution_.count()) / resolution_.count(); }
+
+	std::int64_t ceil_tick(TimePoint t) const {
+		const std::int64_t tick = floor_tick(t);
+		return TimePoint(resolution_ * tick) < t ? tick + 1 : tick;
+	}
+
+	// The bucket for `deadline`, created and placed in the wheel if no timer has that deadline yet
+	Bucket &bucket(std::int64_t deadline) {
+		auto    inserted = buckets_.emplace(deadline, Bucket());
+		Bucket &b        = inserted.first->second;
+		if (inserted.second) {
+			b.deadline = deadline;
+			place(b);
+			if (next_known_ && deadline < next_) { next_ = deadline; }
+		}
+		return b;
+	}
+
+	void drop(Buckets::iterator it) {
+		displace(it->second);
+		if (it->first == next_) { next_known_ = false; }
+		buckets_.erase(it);
+	}
+
+	// Link a bucket into the level of the highest bit where its deadline differs from `now_`
+	void place(Bucket &b) {
+		const std::uint64_t deadline = static_cast<std::uint64_t>(b.deadline);
+		const std::uint64_t diff     = deadline ^ static_cast<std::uint64_t>(now_);
+		b.level                      = diff ? top_bit(diff) / SLOT_BITS : 0;
+		b.slot                       = static_cast<unsigned>(deadline >> (b.level * SLOT_BITS)) & (SLOTS - 1);
+		b.prev                       = nullptr;
+		b.next                       = slots_[b.level][b.slot];
+		if (b.next) { b.next->prev = &b; }
+		slots_[b.level][b.slot] = &b;
+		occupied_[b.level] |= std::uint64_t(1) << b.slot;
+	}
+
+	void displace(Bucket &b) {
+		if (b.prev) {
+			b.prev->next = b.next;
+		} else {
+			slots_[b.level][b.slot] = b.next;
+		}
+		if (b.next) { b.next->prev = b.prev; }
+		if (!slots_[b.level][b.slot]) { occupied_[b.level] &= ~(std::uint64_t(1) << b.slot); }
+	}
+
+	// First occupied slot of the lowest occupied level, and the tick it starts at. Every deadline on a level
+	// comes before any deadline on the levels above it.
+	bool next_slot(unsigned &level, unsigned &slot, std::int64_t &start) const {
+		const std::uint64_t now = static_cast<std::uint64_t>(now_);
+		for (level = 0; level < LEVELS; ++level) {
+			if (!occupied_[level]) { continue; }
+			const unsigned      shift = level * SLOT_BITS;
+			const unsigned      above = shift + SLOT_BITS;
+			const std::uint64_t block = above < 64 ? now >> above << above : 0;
+			slot                      = low_bit(occupied_[level]);
+			start                     = static_cast<std::int64_t>(block | std::uint64_t(slot) << shift);
+			return true;
+		}
+		return false;
+	}
+
+	std::int64_t earliest() const {
+		unsigned     level = 0;
+		unsigned     slot  = 0;
+		std::int64_t start = 0;
+		if (!next_slot(level, slot, start)) { return never; }
+		std::int64_t first = never;
+		for (const Bucket *b = slots_[level][slot]; b; b = b->next) { first = std::min(first, b->deadline); }
+		return first;
+	}
+
+	std::uint32_t acquire() {
+		std::uint32_t index = free_;
+		if (index != npos) {
+			free_ = nodes_[index].next;
+		} else {
+			index = static_cast<std::uint32_t>(nodes_.size());
+			nodes_.emplace_back();
+		}
+		Node &n  = nodes_[index];
+		n.prev   = npos;
+		n.next   = npos;
+		n.armed  = true;
+		n.firing = false;
+		return index;
+	}
+
+	void release(std::uint32_t index) {
+		Node &n = nodes_[index];
+		n.callback = nullptr;
+		n.armed    = false;
+		n.firing   = false;
+		++n.generation;
+		n.prev = npos;
+		n.next = free_;
+		free_  = index;
+	}
+
+	// Return the unfired rest of the detached bucket to the wheel under its deadline
+	void requeue_firing() {
+		while (firing_ != npos) {
+			const std::uint32_t index = firing_;
+			unlink(index, firing_);
+			nodes_[index].firing = false;
+			link(index, bucket(nodes_[index].deadline).head);
+		}
+	}
+
+	void link(std::uint32_t index, std::uint32_t &head) {
+		nodes_[index].prev = npos;
+		nodes_[index].next = head;
+		if (head != npos) { nodes_[head].prev = index; }
+		head = index;
+	}
+
+	void unlink(std::uint32_t index, std::uint32_t &head) {
+		Node &n = nodes_[index];
+		if (n.prev != npos) {
+			nodes_[n.prev].next = n.next;
+		} else {
+			head = n.next;
+		}
+		if (n.next != npos) { nodes_[n.next].prev = n.prev; }
+		n.prev = n.next = npos;
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_TIMER_HPP
@@ -0,0 +1,281 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_TRACE_HPP
+#define HSM_TRACE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "hsm.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// Trace Encoding
+// ============================================================================
+//
+// A trace is a byte stream of records, each starting with a tag byte whose low
+// three bits hold the `TraceKind`. Timed records follow the tag with the
+// nanoseconds elapsed since the previous timed record as a varint:
+//
+//   Dispatch    tag, delta, event
+//   Transition  tag, delta, from, to
+//   Step        tag, delta              (tag bit 3: handled)
+//
+// States are written as their `State::index()`. Events are numbered per
+// stream in order of first dispatch, 0, 1, 2 and so on, so the ids and the
+// encoded size depend only on what the machine did, not on which types the
+// rest of the process used first. The first use of a state or event is
+// preceded by a dictionary record carrying its name:
+//
+//   StateName   tag, index, length, bytes
+//   EventName   tag, event, length, bytes
+//
+// Dispatching the base `Event` type is named "Event" whatever the dynamic
+// type. Varints are little-endian base-128. Dictionaries are per stream, so
+// each encoder covers one machine.
+
+enum class TraceKind : std::uint8_t { Dispatch, Transition, Step, StateName, EventName };
+
+/// @brief One timed record read back by `TraceDecoder`
+struct TraceRecord {
+	TraceKind     kind    = TraceKind::Dispatch;
+	std::int64_t  time    = 0;                // Clock reading, reconstructed from the deltas
+	std::size_t   event   = std::size_t(-1);  // Dispatch: per-stream event id
+	std::uint32_t from    = 0;                // Transition: source state index
+	std::uint32_t to      = 0;                // Transition: settled state index
+	bool          handled = false;            // Step: some handler returned `Result::Done`
+};
+
+namespace detail {
+
+inline void put_varint(std::vector<std::uint8_t> &out, std::uint64_t v) {
+	while (v >= 0x80) {
+		out.push_back(static_cast<std::uint8_t>(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<std::uint8_t>(v));
+}
+
+// Returns false without moving `pos` past `end` if the varint is incomplete; throws once it outgrows 64 bits
+inline bool get_varint(const std::uint8_t *&pos, const std::uint8_t *end, std::uint64_t &v) {
+	v = 0;
+	for (unsigned shift = 0; pos != end; shift += 7) {
+		const std::uint8_t b = *pos++;
+		v |= std::uint64_t(b & 0x7F) << shift;
+		if (!(b & 0x80)) { return true; }
+		if (shift + 7 > 63) { throw std::runtime_error("Malformed trace varint"); }
+	}
+	return false;
+}
+
+}  // namespace detail
+
+/// @brief Observer appending a compact trace of one machine to an in-memory buffer
+/// @note Drain `bytes()` and `clear()` as often as needed; the stream stays decodable across clears
+template <typename Traits>
+class TraceEncoder : public Observer<Traits> {
+public:
+	using Clock = std::int64_t (*)();
+
+	/// @param clock Nanosecond time source; must not go backwards
+	explicit TraceEncoder(Clock clock = detail::steady_ns) : clock_(clock) {}
+
+	/// @brief Encoded bytes since the last `clear()`
+	const std::vector<std::uint8_t> &bytes() const { return out_; }
+
+	/// @brief Discard the encoded bytes, keeping dictionaries and the time base
+	void clear() { out_.clear(); }
+
+	void on_dispatch(const Machine<Traits> &, const typename Traits::Event &evt, std::size_t type) override {
+		// The base `Event` arrives as `size_t(-1)` and takes slot 0; types are shifted up by one
+		const std::size_t slot = type + 1;
+		if (slot >= ids_.size()) { ids_.resize(slot + 1, 0); }
+		std::uint32_t &id = ids_[slot];
+		if (!id) {
+			id = ++next_id_;
+			define(TraceKind::EventName, id - 1, slot ? typeid(evt).name() : "Event");
+		}
+		timed(TraceKind::Dispatch, 0);
+		detail::put_varint(out_, id - 1);
+	}
+
+	void on_transition(const Machine<Traits> &, const State<Traits> *from, const State<Traits> *to) override {
+		name(from);
+		name(to);
+		timed(TraceKind::Transition, 0);
+		detail::put_varint(out_, from->index());
+		detail::put_varint(out_, to->index());
+	}
+
+	void on_step(const Machine<Traits> &sm) override { timed(TraceKind::Step, sm.handled() ? 1 : 0); }
+
+private:
+	Clock                      clock_;
+	std::int64_t               last_ = 0;
+	std::vector<std::uint8_t>  out_;
+	std::vector<bool>          states_;
+	std::vector<std::uint32_t> ids_;          // Stream event id + 1 by type index + 1, 0 until first dispatched
+	std::uint32_t              next_id_ = 0;  // Event ids handed out so far
+
+	void timed(TraceKind kind, std::uint8_t flag) {
+		const std::int64_t now = clock_();
+		out_.push_back(static_cast<std::uint8_t>(static_cast<std::uint8_t>(kind) | flag << 3));
+		detail::put_varint(out_, static_cast<std::uint64_t>(now - last_));
+		last_ = now;
+	}
+
+	void name(const State<Traits> *s) {
+		if (s->index() >= states_.size()) { states_.resize(s->index() + 1, false); }
+		if (states_[s->index()]) { return; }
+		states_[s->index()] = true;
+		define(TraceKind::StateName, s->index(), s->name());
+	}
+
+	void define(TraceKind kind, std::uint64_t key, const std::string &text) {
+		out_.push_back(static_cast<std::uint8_t>(kind));
+		detail::put_varint(out_, key);
+		detail::put_varint(out_, text.size());
+		out_.insert(out_.end(), text.begin(), text.end());
+	}
+};
+
+/// @brief Incremental reader for streams written by `TraceEncoder`
+class TraceDecoder {
+public:
+	/// @brief Append raw bytes; they may split records anywhere
+	void feed(const void *data, std::size_t size) {
+		const auto *p = static_cast<const std::uint8_t *>(data);
+		buf_.insert(buf_.end(), p, p + size);
+	}
+
+	/// @brief Decode the next timed record, absorbing dictionary records on the way
+	/// @return False once the buffered bytes hold no complete record
+	/// @throws std::runtime_error If the stream is malformed
+	bool next(TraceRecord &record) {
+		for (;;) {
+			const std::uint8_t *pos = buf_.data() + pos_;
+			const std::uint8_t *end = buf_.data() + buf_.size();
+			if (pos == end) { break; }
+
+			const std::uint8_t tag  = *pos++;
+			const auto         kind = static_cast<TraceKind>(tag & 7);
+			std::uint64_t      a = 0, b = 0, c = 0;
+			switch (kind) {
+			case TraceKind::StateName:
+			case TraceKind::EventName: {
+				if (!detail::get_varint(pos, end, a) || !detail::get_varint(pos, end, b)) { return compact(); }
+				if (static_cast<std::uint64_t>(end - pos) < b) { return compact(); }
+				const std::string name(reinterpret_cast<const char *>(pos), b);
+				if (kind == TraceKind::StateName) {
+					if (a > 0xFFFFFFFFu) { throw std::runtime_error("Malformed trace state index"); }
+					name_state(static_cast<std::uint32_t>(a), name);
+				} else {
+					// Event ids are dense, so a definition either names the next id or repeats a known one
+					if (a > events_.size()) { throw std::runtime_error("Malformed trace event id"); }
+					if (a == events_.size()) { events_.emplace_back(); }
+					events_[a] = name;
+				}
+				pos_ = pos + b - buf_.data();
+				continue;
+			}
+			case TraceKind::Dispatch:
+				if (!detail::get_varint(pos, end, a) || !detail::get_varint(pos, end, b)) { return compact(); }
+				if (b >= events_.size()) { throw std::runtime_error("Malformed trace event id"); }
+				record       = TraceRecord();
+				record.event = static_cast<std::size_t>(b);
+				break;
+			case TraceKind::Transition:
+				if (!detail::get_varint(pos, end, a) || !detail::get_varint(pos, end, b) || !detail::get_varint(pos, end, c)) { return compact(); }
+				record      = TraceRecord();
+				record.from = static_cast<std::uint32_t>(b);
+				record.to   = static_cast<std::uint32_t>(c);
+				break;
+			case TraceKind::Step:
+				if (!detail::get_varint(pos, end, a)) { return compact(); }
+				record         = TraceRecord();
+				record.handled = (tag >> 3) & 1;
+				break;
+			default:
+				throw std::runtime_error("Malformed trace record");
+			}
+			time_ += static_cast<std::int64_t>(a);
+			record.kind = kind;
+			record.time = time_;
+			pos_        = pos - buf_.data();
+			return true;
+		}
+		compact();
+		return false;
+	}
+
+	/// @brief Name of a state index seen in the stream, or an empty string
+	const std::string &state_name(std::uint32_t index) const {
+		auto it = std::lower_bound(states_.begin(), states_.end(), index, by_index);
+		return it != states_.end() && it->first == index ? it->second : none();
+	}
+
+	/// @brief Name of an event id seen in the stream, or an empty string
+	const std::string &event_name(std::size_t event) const { return event < events_.size() ? events_[event] : none(); }
+
+private:
+	std::vector<std::uint8_t> buf_;
+	std::size_t               pos_  = 0;
+	std::int64_t              time_ = 0;
+	std::vector<std::pair<std::uint32_t, std::string>> states_;  // Sorted by index; indices from the stream may be sparse
+	std::vector<std::string>                           events_;  // Indexed by event id
+
+	// Drop consumed bytes; returns false for the caller's "need more input" path
+	bool compact() {
+		buf_.erase(buf_.begin(), buf_.begin() + static_cast<std::ptrdiff_t>(pos_));
+		pos_ = 0;
+		return false;
+	}
+
+	static bool by_index(const std::pair<std::uint32_t, std::string> &entry, std::uint32_t index) { return entry.first < index; }
+
+	static const std::string &none() {
+		static const std::string empty;
+		return empty;
+	}
+
+	void name_state(std::uint32_t index, const std::string &name) {
+		auto it = std::lower_bound(states_.begin(), states_.end(), index, by_index);
+		if (it != states_.end() && it->first == index) {
+			it->second = name;
+		} else {
+			states_.emplace(it, index, name);
+		}
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_TRACE_HPP
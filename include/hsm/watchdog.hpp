@@ -0,0 +1,148 @@
+/*
+ * HSM Version 0.1.4
+ *
+ * MIT License
+ *
+ * Copyright (c) 2026 tayne3
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef HSM_WATCHDOG_HPP
+#define HSM_WATCHDOG_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hsm.hpp"
+
+namespace hsm {
+
+// ============================================================================
+// Watchdog
+// ============================================================================
+
+/// @brief An action observed running longer than the watchdog threshold
+struct WatchReport {
+	const char              *state;    // `State::name()` of the executing state
+	const char              *action;   // "handle", "on_entry" or "on_exit"
+	const char              *event;    // `typeid(event).name()` for "handle", null otherwise
+	std::chrono::nanoseconds elapsed;  // Time spent in the action when it was observed
+};
+
+/// @brief Monitor thread reporting handlers and entry/exit actions that exceed a time threshold
+/// @note Machines only write to a per-thread `WatchSlot`; no locks are taken on the dispatch path
+class Watchdog {
+public:
+	using Callback = std::function<void(const WatchReport &)>;
+
+	/// @param threshold Minimum action duration to report
+	/// @param callback Invoked on the monitor thread, at most once per overrunning action; must not call `attach`/`detach`
+	/// @param period Sampling interval; defaults to a quarter of the threshold
+	Watchdog(std::chrono::nanoseconds threshold, Callback callback, std::chrono::nanoseconds period = std::chrono::nanoseconds::zero())
+		: threshold_(threshold), period_(period > std::chrono::nanoseconds::zero() ? period : threshold / 4), callback_(std::move(callback)) {
+		if (period_ <= std::chrono::nanoseconds::zero()) { period_ = std::chrono::milliseconds(1); }
+		thread_ = std::thread([this] { run(); });
+	}
+
+	~Watchdog() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+		cv_.notify_all();
+		thread_.join();
+	}
+
+	Watchdog(const Watchdog &)            = delete;
+	Watchdog &operator=(const Watchdog &) = delete;
+
+	/// @brief Start observing machines driven by the calling thread
+	/// @note Call `detach()` on the same thread before it exits or the watchdog is destroyed
+	void attach() {
+		auto                       *&slot = detail::watch_slot();
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (slot) { return; }
+		entries_.emplace_back(new Entry());
+		slot = &entries_.back()->slot;
+	}
+
+	/// @brief Stop observing the calling thread
+	void detach() {
+		auto                       *&slot = detail::watch_slot();
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+			if (&(*it)->slot == slot) {
+				entries_.erase(it);
+				break;
+			}
+		}
+		slot = nullptr;
+	}
+
+private:
+	struct Entry {
+		WatchSlot     slot;
+		std::uint64_t reported = 0;  // Last `seq` reported, touched by the monitor only
+	};
+
+	std::chrono::nanoseconds            threshold_;
+	std::chrono::nanoseconds            period_;
+	Callback                            callback_;
+	std::vector<std::unique_ptr<Entry>> entries_;
+	std::mutex                          mutex_;
+	std::condition_variable             cv_;
+	bool                                stopping_ = false;
+	std::thread                         thread_;
+
+	void run() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (!cv_.wait_for(lock, period_, [this] { return stopping_; })) {
+			const std::int64_t now = detail::steady_ns();
+			for (auto &e : entries_) { inspect(*e, now); }
+		}
+	}
+
+	void inspect(Entry &e, std::int64_t now) {
+		WatchSlot          &slot = e.slot;
+		const std::uint64_t seq  = slot.seq.load(std::memory_order_acquire);
+		if (!(seq & 1) || seq == e.reported) { return; }
+
+		WatchReport report;
+		report.state             = slot.state.load(std::memory_order_relaxed);
+		report.action            = slot.action.load(std::memory_order_relaxed);
+		report.event             = slot.event.load(std::memory_order_relaxed);
+		const std::int64_t since = slot.since.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.seq.load(std::memory_order_relaxed) != seq) { return; }
+
+		report.elapsed = std::chrono::nanoseconds(now - since);
+		if (report.elapsed < threshold_) { return; }
+		e.reported = seq;
+		callback_(report);
+	}
+};
+
+}  // namespace hsm
+
+#endif  // HSM_WATCHDOG_HPP
@@ -0,0 +1,177 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Ping : BaseEvent {};
+struct Pong : BaseEvent {};
+struct Noise : BaseEvent {};
+template <int N>
+struct Late : BaseEvent {};
+
+struct FilterTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int calls = 0;
+		int pongs = 0;
+	};
+};
+
+using Machine = hsm::Machine<FilterTraits>;
+using Scope   = hsm::Scope<FilterTraits>;
+
+enum { GROUP, WAIT_PING, WAIT_PONG, OTHER };
+
+// Counts every invocation so that skipped virtual calls are observable
+hsm::Result handler(Machine &sm, const BaseEvent &ev) {
+	sm->calls++;
+	return hsm::match(sm, ev)
+		.on<Ping>([](Machine &sm, const Ping &) {
+			sm.dispatch(Pong{});   // Queued: accepted elsewhere in the machine
+			sm.dispatch(Noise{});  // Queued: accepted nowhere
+			sm.transition(WAIT_PONG);
+			return hsm::Result::Done;
+		})
+		.on<Pong>([](Machine &sm, const Pong &) {
+			sm->pongs++;
+			return hsm::Result::Done;
+		});
+}
+
+void build(Scope &s) {
+	s.state(GROUP).with([](Scope &s) {
+		s.state(WAIT_PING).accepts<Ping>().handle(handler);
+		s.state(WAIT_PONG).accepts<Pong>().handle(handler);
+	});
+	s.state(OTHER).accepts<>().handle(handler);
+}
+
+// Insert one state per `Late<N>`, each bringing an event type the machine has not seen
+template <int N>
+void accept_late(Machine &sm) {
+	sm.insert([](Scope &s) { s.state(100 + N).accepts<Late<N>>(); });
+	accept_late<N - 1>(sm);
+}
+template <>
+void accept_late<-1>(Machine &) {}
+
+}  // namespace
+
+TEST_CASE("Events nobody on the active path accepts are dropped", "[hsm][accept]") {
+	Machine sm;
+	sm.start(WAIT_PING, build);
+
+	SECTION("Direct dispatch of an unaccepted type never reaches a handler") {
+		sm.dispatch(Pong{});
+		sm.dispatch(Noise{});
+		REQUIRE(sm->calls == 0);
+		REQUIRE(sm.stats().unhandleable == 2);
+	}
+
+	SECTION("Queued events are checked against the path active when they run") {
+		sm.dispatch(Ping{});
+		REQUIRE(sm.current_state_id() == WAIT_PONG);
+		REQUIRE(sm->pongs == 1);
+		REQUIRE(sm->calls == 2);
+		REQUIRE(sm.stats().unhandleable == 1);  // Noise, refused at enqueue
+	}
+
+	SECTION("Dispatching the base type bypasses filtering") {
+		sm.dispatch(static_cast<const BaseEvent &>(Noise{}));
+		REQUIRE(sm->calls == 1);
+		REQUIRE(sm.stats().unhandleable == 0);
+	}
+
+	SECTION("An empty declaration accepts nothing") {
+		sm.transition(OTHER);
+		sm.dispatch(Ping{});
+		REQUIRE(sm->calls == 0);
+	}
+}
+
+TEST_CASE("Undeclared handlers keep accepting everything", "[hsm][accept]") {
+	Machine sm;
+	sm.start(WAIT_PING, [](Scope &s) {
+		s.state(GROUP).handle(handler).with([](Scope &s) { s.state(WAIT_PING).accepts<Ping>(); });
+	});
+
+	sm.dispatch(Noise{});
+	REQUIRE(sm->calls == 1);
+	REQUIRE(sm.stats().unhandleable == 0);
+}
+
+TEST_CASE("Dispatch visits only ancestors that accept the type", "[hsm][accept]") {
+	Machine sm;
+	sm.start(WAIT_PING, [](Scope &s) {
+		s.state(GROUP).accepts<Pong>().handle(handler).with([](Scope &s) {
+			s.state(WAIT_PONG).accepts<Ping>().handle(handler).with([](Scope &s) { s.state(WAIT_PING).accepts<Ping>().handle(handler); });
+		});
+	});
+
+	for (int i = 0; i < 3; ++i) { sm.dispatch(Pong{}); }
+
+	REQUIRE(sm->calls == 3);  // GROUP only; both Ping-only descendants are skipped
+	REQUIRE(sm->pongs == 3);
+	REQUIRE(sm.current_state_id() == WAIT_PING);
+}
+
+TEST_CASE("Pruned states take their accepted types with them", "[hsm][accept]") {
+	Machine sm;
+	sm.prune_unreachable(true);
+	sm.start(WAIT_PING, [](Scope &s) {
+		s.state(WAIT_PING).accepts<Ping>().targets({WAIT_PING}).handle(handler);
+		s.state(WAIT_PONG).accepts<Pong>().targets({WAIT_PONG}).handle(handler);
+	});
+
+	REQUIRE(sm.unreachable_states() == std::vector<int>{WAIT_PONG});
+	sm.dispatch(Pong{});
+	REQUIRE(sm->calls == 0);
+	REQUIRE(sm.stats().unhandleable == 1);
+	REQUIRE_FALSE(sm.post(Pong{}).handled());
+	REQUIRE(sm.stats().unhandleable == 1);
+	REQUIRE(sm.drain() == 0);
+	REQUIRE(sm.stats().unhandleable == 2);
+}
+
+TEST_CASE("Posts read accept masks published by the owner", "[hsm][accept]") {
+	Machine sm;
+	sm.start(WAIT_PING, build);
+
+	// Widening the masks past 64 types reallocates them while the poster checks every post
+	std::atomic<bool> done{false};
+	std::thread       poster([&] {
+		while (!done.load()) { sm.post(Late<0>{}); }
+	});
+	accept_late<130>(sm);
+	done = true;
+	poster.join();
+
+	REQUIRE_FALSE(sm.post(Late<0>{}).ready());
+	REQUIRE_FALSE(sm.post(Late<130>{}).ready());
+	REQUIRE(sm.post(Noise{}).ready());
+	sm.drain();
+}
+
+TEST_CASE("Cached routes follow types brought in by inserted states", "[hsm][accept]") {
+	Machine sm;
+	sm.start(WAIT_PONG, build);
+	sm.dispatch(Pong{});
+
+	sm.insert(WAIT_PONG, [](Scope &s) { s.state(200).accepts<Late<7>>().handle(handler); });
+	sm.dispatch(Pong{});
+	sm.transition(200);
+	sm.dispatch(Late<7>{});
+	sm.dispatch(Pong{});  // Skips the new state, still reaches its parent
+
+	REQUIRE(sm->calls == 4);
+	REQUIRE(sm->pongs == 3);
+	REQUIRE(sm.stats().unhandleable == 0);
+}
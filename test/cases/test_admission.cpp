@@ -0,0 +1,162 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/executor.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Slow : BaseEvent {};
+struct Fast : BaseEvent {};
+
+struct AdmitTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int slows = 0;
+		int fasts = 0;
+	};
+};
+
+using Machine  = hsm::Machine<AdmitTraits>;
+using Scope    = hsm::Scope<AdmitTraits>;
+using Executor = hsm::Executor<AdmitTraits>;
+
+void build(Scope &s) {
+	s.state(0).accepts<Slow, Fast>().handle([](Machine &sm, const BaseEvent &ev) {
+		return hsm::match(sm, ev)
+			.on<Slow>([](Machine &sm, const Slow &) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				sm->slows++;
+				return hsm::Result::Done;
+			})
+			.on<Fast>([](Machine &sm, const Fast &) {
+				sm->fasts++;
+				return hsm::Result::Done;
+			});
+	});
+}
+
+}  // namespace
+
+TEST_CASE("Posts predicted to miss the SLO are shed", "[hsm][admission]") {
+	Machine sm;
+	sm.start(0, build);
+
+	// Learn the service time under an SLO loose enough to admit everything
+	sm.admission(std::chrono::hours(1));
+	sm.post(Slow{});
+	sm.drain();
+	const std::chrono::nanoseconds service = sm.service_time<Slow>();
+	REQUIRE(service >= std::chrono::milliseconds(2));
+
+	std::vector<std::chrono::nanoseconds> shed;
+	sm.admission(service * 5 / 2, [&](const BaseEvent &, std::chrono::nanoseconds predicted) { shed.push_back(predicted); });
+
+	Machine::Ticket first  = sm.post(Slow{});
+	Machine::Ticket second = sm.post(Slow{});
+	Machine::Ticket third  = sm.post(Slow{});
+	REQUIRE_FALSE(first.ready());
+	REQUIRE_FALSE(second.ready());
+	REQUIRE(third.ready());
+	REQUIRE_FALSE(third.handled());
+	REQUIRE(shed == std::vector<std::chrono::nanoseconds>{service * 3});
+	REQUIRE(sm.backlog() == service * 2);
+
+	SECTION("Draining frees the budget again") {
+		REQUIRE(sm.drain() == 2);
+		REQUIRE(sm->slows == 3);
+		REQUIRE(sm.stats().shed == 1);
+		REQUIRE(sm.backlog() == std::chrono::nanoseconds::zero());
+		REQUIRE_FALSE(sm.post(Slow{}).ready());
+	}
+
+	SECTION("Unmeasured types are admitted") {
+		REQUIRE_FALSE(sm.post(Fast{}).ready());
+		REQUIRE(sm.drain() == 3);
+		REQUIRE(sm->fasts == 1);
+	}
+
+	SECTION("A zero SLO turns shedding off") {
+		sm.admission(std::chrono::nanoseconds::zero());
+		for (int i = 0; i < 5; ++i) { REQUIRE_FALSE(sm.post(Slow{}).ready()); }
+		REQUIRE(shed.size() == 1);
+	}
+}
+
+TEST_CASE("Executor sheds posts to machines that would run too late", "[hsm][admission]") {
+	Machine sm;
+	sm.start(0, build);
+	Executor executor(1);
+	auto     h = executor.add(sm, 0);
+
+	int shed = 0;
+	executor.admission(std::chrono::nanoseconds(1), [&](const BaseEvent &, std::chrono::nanoseconds) { ++shed; });
+
+	// Nothing is known about `Slow` yet, so the first one runs and teaches the machine its cost
+	REQUIRE(executor.post(h, Slow{}).handled());
+
+	Machine::Ticket late = executor.post(h, Slow{});
+	REQUIRE(late.ready());
+	REQUIRE_FALSE(late.handled());
+	REQUIRE(shed == 1);
+	REQUIRE(sm->slows == 1);
+}
+
+TEST_CASE("Service times are measured only under admission control", "[hsm][admission]") {
+	Machine sm;
+	sm.start(0, build);
+
+	sm.post(Slow{});
+	sm.drain();
+	REQUIRE(sm.service_time<Slow>() == std::chrono::nanoseconds::zero());
+
+	sm.admission(std::chrono::hours(1));
+	sm.post(Slow{});
+	sm.post(Fast{});
+	sm.drain();
+	REQUIRE(sm.service_time<Slow>() >= std::chrono::milliseconds(2));
+	REQUIRE(sm.service_time<Fast>() < sm.service_time<Slow>());
+	REQUIRE(sm->slows == 2);
+}
+
+TEST_CASE("Bounded drains time the batch they left behind", "[hsm][admission]") {
+	Machine sm;
+	sm.start(0, build);
+	sm.admission(std::chrono::hours(1));
+
+	sm.post(Fast{});
+	sm.post(Slow{});
+	REQUIRE(sm.drain(1) == 1);
+	REQUIRE(sm.drain(1) == 1);
+	REQUIRE(sm.service_time<Slow>() >= std::chrono::milliseconds(2));
+	REQUIRE(sm.backlog() == std::chrono::nanoseconds::zero());
+}
+
+TEST_CASE("Executor admission leaves machines with their own settings alone", "[hsm][admission]") {
+	Machine own, shared, pinned;
+	own.start(0, build);
+	shared.start(0, build);
+	pinned.start(0, build);
+	own.admission(std::chrono::hours(1));
+
+	Executor executor(1);
+	executor.add(own, 0);
+	executor.add(shared, 0);
+	auto h = executor.add(pinned, 0);
+	executor.admission(h, std::chrono::hours(2));
+
+	executor.admission(std::chrono::milliseconds(5));
+	REQUIRE(own.admission_slo() == std::chrono::hours(1));
+	REQUIRE(shared.admission_slo() == std::chrono::milliseconds(5));
+	REQUIRE(pinned.admission_slo() == std::chrono::hours(2));
+
+	executor.admission(std::chrono::nanoseconds::zero());
+	REQUIRE(own.admission_slo() == std::chrono::hours(1));
+	REQUIRE(shared.admission_slo() == std::chrono::nanoseconds::zero());
+	REQUIRE(pinned.admission_slo() == std::chrono::hours(2));
+}
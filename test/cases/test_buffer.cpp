@@ -0,0 +1,91 @@
+#include <cstring>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/buffer.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Packet : BaseEvent {
+	hsm::BufferRef body;
+};
+struct Flush : BaseEvent {};
+
+struct BufferTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		std::vector<const std::uint8_t *> seen;
+		std::vector<std::uint32_t>        refs;
+		hsm::BufferRef                   *probe = nullptr;
+	};
+};
+
+using Machine = hsm::Machine<BufferTraits>;
+using Scope   = hsm::Scope<BufferTraits>;
+
+void build(Scope &s) {
+	s.state(0).handle([](Machine &sm, const BaseEvent &ev) {
+		return hsm::match(sm, ev)
+			.on<Flush>([](Machine &sm, const Flush &) {
+				// Re-raise the probe while dispatching, so it is queued
+				Packet p;
+				p.body = *sm->probe;
+				sm.dispatch(p);
+				sm->refs.push_back(sm->probe->use_count());
+				return hsm::Result::Done;
+			})
+			.on<Packet>([](Machine &sm, const Packet &p) {
+				sm->seen.push_back(p.body.data());
+				sm->refs.push_back(p.body.use_count());
+				return hsm::Result::Done;
+			});
+	});
+}
+
+int released = 0;
+
+void on_release(void *context, const std::uint8_t *) {
+	++released;
+	*static_cast<bool *>(context) = true;
+}
+
+}  // namespace
+
+TEST_CASE("Queued view events share the buffer instead of copying it", "[hsm][buffer]") {
+	hsm::BufferRef buf = hsm::BufferRef::allocate(1500);
+	std::memset(buf.mutable_data(), 0xAB, buf.size());
+
+	Machine sm;
+	sm.start(0, build);
+	sm->probe = &buf;
+	sm.dispatch(Flush{});
+
+	REQUIRE(sm->seen == std::vector<const std::uint8_t *>{buf.data()});
+	// Queued copy and local pin, then just the queued copy during its step
+	REQUIRE(sm->refs == std::vector<std::uint32_t>{3, 2});
+	REQUIRE(buf.use_count() == 1);
+}
+
+TEST_CASE("Adopted buffers are released with the last reference", "[hsm][buffer]") {
+	static const std::uint8_t ring[64] = {};
+	bool                      done     = false;
+	released                           = 0;
+	{
+		hsm::BufferRef lease = hsm::BufferRef::adopt(ring, sizeof(ring), on_release, &done);
+		hsm::BufferRef head  = lease.slice(8, 16);
+		REQUIRE(head.data() == ring + 8);
+		REQUIRE(head.size() == 16);
+		REQUIRE(lease.use_count() == 2);
+		REQUIRE_THROWS_AS(lease.mutable_data(), std::logic_error);
+		REQUIRE_THROWS_AS(lease.slice(60, 8), std::out_of_range);
+
+		lease = hsm::BufferRef();
+		REQUIRE_FALSE(done);
+	}
+	REQUIRE(done);
+	REQUIRE(released == 1);
+}
@@ -0,0 +1,106 @@
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct Event {};
+
+struct CompletionTraits {
+	using StateID = int;
+	using Event   = ::Event;
+	struct Context {
+		bool                     ready   = false;
+		int                      handled = 0;
+		std::vector<std::string> log;
+	};
+};
+
+using Machine = hsm::Machine<CompletionTraits>;
+using Scope   = hsm::Scope<CompletionTraits>;
+
+enum { BOOT, CHECK, READY, WAITING, GROUP, INNER };
+
+hsm::Result count(Machine &sm, const Event &) {
+	sm->handled++;
+	return hsm::Result::Done;
+}
+
+void build(Scope &s) {
+	s.state(BOOT).on_entry([](Machine &sm) { sm->log.push_back("Boot"); }).completion(CHECK);
+	s.state(CHECK)
+		.on_entry([](Machine &sm) { sm->log.push_back("Check"); })
+		.completion(READY, [](Machine &sm) { return sm->ready; })
+		.completion(WAITING);
+	s.state(READY).on_entry([](Machine &sm) { sm->log.push_back("Ready"); }).handle(count);
+	s.state(WAITING).on_entry([](Machine &sm) { sm->log.push_back("Waiting"); }).handle(count);
+}
+
+}  // namespace
+
+TEST_CASE("Completion transitions run without events", "[hsm][completion]") {
+	Machine sm;
+
+	SECTION("The first guard that holds is taken") {
+		sm->ready = true;
+		sm.start(BOOT, build);
+		REQUIRE(sm.current_state_id() == READY);
+		REQUIRE(sm->log == std::vector<std::string>{"Boot", "Check", "Ready"});
+	}
+
+	SECTION("Unguarded completions act as a fallback") {
+		sm.start(BOOT, build);
+		REQUIRE(sm.current_state_id() == WAITING);
+		REQUIRE(sm->log == std::vector<std::string>{"Boot", "Check", "Waiting"});
+	}
+
+	SECTION("No handler sees a synthetic event") {
+		sm.start(BOOT, build);
+		REQUIRE(sm->handled == 0);
+	}
+
+	SECTION("Completions also follow transitions requested by handlers") {
+		sm.start(BOOT, build);
+		sm->log.clear();
+		sm->ready = true;
+		sm.transition(CHECK);
+		REQUIRE(sm.current_state_id() == READY);
+		REQUIRE(sm->log == std::vector<std::string>{"Check", "Ready"});
+	}
+}
+
+TEST_CASE("Completion of a nested target", "[hsm][completion]") {
+	Machine sm;
+	sm.start(BOOT, [](Scope &s) {
+		s.state(BOOT);
+		s.state(GROUP).completion(BOOT).with([](Scope &s) { s.state(INNER).completion(WAITING); });
+		s.state(WAITING);
+	});
+
+	// Only the entered target completes, not its ancestors
+	sm.transition(INNER);
+	REQUIRE(sm.current_state_id() == WAITING);
+}
+
+TEST_CASE("Completion cycles are caught by the loop guard", "[hsm][completion]") {
+	Machine sm;
+	REQUIRE_THROWS_AS(sm.start(BOOT,
+							   [](Scope &s) {
+								   s.state(BOOT).completion(CHECK);
+								   s.state(CHECK).completion(BOOT);
+							   }),
+					  std::runtime_error);
+}
+
+TEST_CASE("Completion declarations are validated", "[hsm][completion]") {
+	Machine sm;
+	REQUIRE_THROWS_AS(sm.start(BOOT, [](Scope &s) { s.state(BOOT).completion(42); }), std::invalid_argument);
+	REQUIRE_THROWS_AS(sm.start(BOOT,
+							   [](Scope &s) {
+								   s.state(BOOT);
+								   s.completion(BOOT);
+							   }),
+					  std::logic_error);
+}
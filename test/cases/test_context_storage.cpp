@@ -0,0 +1,95 @@
+#include <memory>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct Tick {};
+
+// Struct-of-arrays fleet storage; each machine borrows one row through a handle context
+struct Columns {
+	std::vector<int> ticks;
+	std::vector<int> entries;
+};
+
+struct RowHandle {
+	Columns    *columns;
+	std::size_t row;
+
+	int &ticks() { return columns->ticks[row]; }
+	int &entries() { return columns->entries[row]; }
+};
+
+struct RowTraits {
+	using StateID = int;
+	using Event   = Tick;
+	using Context = RowHandle;
+};
+
+struct Session {
+	int ticks = 0;
+};
+
+struct BorrowedTraits {
+	using StateID        = int;
+	using Event          = Tick;
+	using Context        = Session;
+	using ContextStorage = hsm::ExternalContext;
+};
+
+}  // namespace
+
+TEST_CASE("Handle contexts address columnar storage", "[hsm][context]") {
+	using Machine = hsm::Machine<RowTraits>;
+
+	Columns columns;
+	columns.ticks.assign(3, 0);
+	columns.entries.assign(3, 0);
+
+	std::vector<std::unique_ptr<Machine>> fleet;
+	for (std::size_t i = 0; i < 3; ++i) {
+		fleet.emplace_back(new Machine(RowHandle{&columns, i}));
+		fleet.back()->start(0, [](hsm::Scope<RowTraits> &s) {
+			s.state(0).on_entry([](Machine &sm) { sm->entries()++; }).handle([](Machine &sm, const Tick &) {
+				sm->ticks()++;
+				return hsm::Result::Done;
+			});
+		});
+	}
+
+	fleet[1]->dispatch(Tick{});
+	fleet[1]->dispatch(Tick{});
+	fleet[2]->dispatch(Tick{});
+
+	REQUIRE(columns.entries == std::vector<int>{1, 1, 1});
+	REQUIRE(columns.ticks == std::vector<int>{0, 2, 1});
+}
+
+TEST_CASE("External contexts are borrowed, not copied", "[hsm][context]") {
+	using Machine = hsm::Machine<BorrowedTraits>;
+
+	Session arena[2];
+	Machine sm(arena[0]);
+	sm.start(0, [](hsm::Scope<BorrowedTraits> &s) {
+		s.state(0).handle([](Machine &sm, const Tick &) {
+			sm->ticks++;
+			return hsm::Result::Done;
+		});
+	});
+
+	SECTION("Context accessors refer to the external object") {
+		sm.dispatch(Tick{});
+		REQUIRE(&sm.context() == &arena[0]);
+		REQUIRE(arena[0].ticks == 1);
+	}
+
+	SECTION("Rebinding redirects subsequent handlers") {
+		sm.rebind_context(arena[1]);
+		sm.dispatch(Tick{});
+		REQUIRE(arena[0].ticks == 0);
+		REQUIRE(arena[1].ticks == 1);
+		REQUIRE(sm.operator->() == &arena[1]);
+	}
+}
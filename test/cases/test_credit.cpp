@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "catch.hpp"
+#include "hsm/credit.hpp"
+#include "hsm/executor.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Produce : BaseEvent {
+	int count;
+	explicit Produce(int count) : count(count) {}
+};
+struct Resume : BaseEvent {};
+struct Item : BaseEvent {};
+
+struct CreditTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		hsm::CreditLink<CreditTraits> *link    = nullptr;
+		int                            pending = 0;  // Producer: items not sent yet
+		int                            pauses  = 0;
+		std::atomic<int>               received{0};  // Consumer
+		std::atomic<std::size_t>       peak{0};      // Consumer: most items in flight seen
+	};
+};
+
+using Machine  = hsm::Machine<CreditTraits>;
+using Scope    = hsm::Scope<CreditTraits>;
+using Link     = hsm::CreditLink<CreditTraits>;
+using Executor = hsm::Executor<CreditTraits>;
+
+enum { RUNNING, PAUSED };
+
+// Send what the link allows, pausing when it runs out of credit
+void pump(Machine &sm) {
+	while (sm->pending > 0 && sm->link->send(Item{})) { sm->pending--; }
+	if (sm->pending > 0) {
+		sm->pauses++;
+		sm.transition(PAUSED);
+	}
+}
+
+void producer(Scope &s) {
+	s.state(RUNNING).handle([](Machine &sm, const BaseEvent &ev) {
+		return hsm::match(sm, ev).on<Produce>([](Machine &sm, const Produce &p) {
+			sm->pending += p.count;
+			pump(sm);
+			return hsm::Result::Done;
+		});
+	});
+	s.state(PAUSED).handle([](Machine &sm, const BaseEvent &ev) {
+		return hsm::match(sm, ev)
+			.on<Produce>([](Machine &sm, const Produce &p) {
+				sm->pending += p.count;
+				return hsm::Result::Done;
+			})
+			.on<Resume>([](Machine &sm, const Resume &) {
+				sm.transition(RUNNING);
+				pump(sm);
+				return hsm::Result::Done;
+			});
+	});
+}
+
+void consumer(Scope &s) {
+	s.state(0).handle([](Machine &sm, const BaseEvent &) {
+		sm->received++;
+		sm->peak = std::max(sm->peak.load(), sm->link->in_flight());
+		return hsm::Result::Done;
+	});
+}
+
+}  // namespace
+
+TEST_CASE("Producer pauses when the consumer has no credit left", "[hsm][credit]") {
+	Machine sink;
+	Machine source;
+	Link    link(sink, 2, [&] { source.post(Resume{}); });
+	sink->link   = &link;
+	source->link = &link;
+	sink.start(0, consumer);
+	source.start(RUNNING, producer);
+
+	source.dispatch(Produce(5));
+	REQUIRE(source.current_state_id() == PAUSED);
+	REQUIRE(link.blocked());
+	REQUIRE(link.credits() == 0);
+	REQUIRE(source->pending == 3);
+
+	// Nothing moves until the consumer drains; each drain returns credit and wakes the producer once
+	REQUIRE(source.drain() == 0);
+	REQUIRE(sink.drain() == 2);
+	REQUIRE_FALSE(link.blocked());
+	REQUIRE(source.drain() == 1);
+	REQUIRE(source->pending == 1);
+
+	REQUIRE(sink.drain() == 2);
+	REQUIRE(source.drain() == 1);
+	REQUIRE(source.current_state_id() == RUNNING);
+	REQUIRE(source->pending == 0);
+	REQUIRE(sink.drain() == 1);
+
+	REQUIRE(sink->received == 5);
+	REQUIRE(sink->peak <= 2);
+	REQUIRE(source->pauses == 2);
+	REQUIRE(link.credits() == 2);
+}
+
+TEST_CASE("Credit flow bounds a fast producer on another shard", "[hsm][credit]") {
+	Machine               sink;
+	Machine               source;
+	std::unique_ptr<Link> link;  // Outlives the executor, whose workers return credits through it
+	Executor              executor(2);
+	sink.start(0, consumer);
+	source.start(RUNNING, producer);
+	auto sink_h   = executor.add(sink, 0);
+	auto source_h = executor.add(source, 1);
+	link.reset(new Link(executor, sink_h, 8, [&] { executor.post(source_h, Resume{}); }));
+	sink->link   = link.get();
+	source->link = link.get();
+
+	for (int i = 0; i < 10; ++i) { executor.post(source_h, Produce(100)); }
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while ((sink->received < 1000 || link->credits() < 8) && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	REQUIRE(sink->received == 1000);
+	REQUIRE(link->credits() == 8);
+	REQUIRE(sink->peak <= 8);
+}
+
+TEST_CASE("Admission never sheds link posts", "[hsm][credit]") {
+	Machine sink;
+	sink.start(0, [](Scope &s) {
+		s.state(0).handle([](Machine &sm, const BaseEvent &) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			sm->received++;
+			return hsm::Result::Done;
+		});
+	});
+	sink.admission(std::chrono::nanoseconds(1));
+	sink.post(Item{});  // Unmeasured yet, so admitted; running it teaches the sink its cost
+	sink.drain();
+	REQUIRE(sink.post(Item{}).refused());
+
+	Link link(sink, 4, nullptr);
+	for (int i = 0; i < 4; ++i) { REQUIRE(link.send(Item{})); }
+	REQUIRE(link.in_flight() == 4);
+	REQUIRE(sink.drain() == 4);
+	REQUIRE(sink->received == 5);
+	REQUIRE(link.credits() == 4);
+}
+
+TEST_CASE("Sends the consumer refuses leave the item with the producer", "[hsm][credit]") {
+	Machine sink;
+	sink.start(0, [](Scope &s) { s.state(0).accepts<Resume>(); });
+	Link link(sink, 2, nullptr);
+
+	REQUIRE_THROWS_AS(link.send(Item{}), std::invalid_argument);
+	REQUIRE(link.credits() == 2);
+	REQUIRE_FALSE(link.blocked());
+	REQUIRE(link.send(Resume{}));
+	REQUIRE(link.in_flight() == 1);
+}
+
+TEST_CASE("CreditLink needs credit", "[hsm][credit]") {
+	Machine sink;
+	REQUIRE_THROWS_AS(Link(sink, 0, nullptr), std::invalid_argument);
+}
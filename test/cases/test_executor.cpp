@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/executor.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Work : BaseEvent {};
+struct Boom : BaseEvent {};
+struct Hop : BaseEvent {
+	int left;
+	explicit Hop(int left) : left(left) {}
+};
+
+struct ExecTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int             count = 0;
+		std::thread::id thread;
+	};
+};
+
+using Machine  = hsm::Machine<ExecTraits>;
+using Scope    = hsm::Scope<ExecTraits>;
+using Executor = hsm::Executor<ExecTraits>;
+
+void build(Scope &s) {
+	s.state(0).handle([](Machine &sm, const BaseEvent &) {
+		sm->count++;
+		sm->thread = std::this_thread::get_id();
+		return hsm::Result::Done;
+	});
+}
+
+template <typename Pred>
+bool eventually(Pred pred) {
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!pred()) {
+		if (std::chrono::steady_clock::now() > deadline) { return false; }
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+}  // namespace
+
+TEST_CASE("Executor runs posted events on the owning shard", "[hsm][executor]") {
+	Machine sm;
+	sm.start(0, build);
+	Executor executor(2);
+	auto     h = executor.add(sm, 1);
+
+	for (int i = 0; i < 10; ++i) { executor.post(h, Work{}); }
+	REQUIRE(executor.post(h, Work{}).handled());
+	REQUIRE(sm->count == 11);
+	REQUIRE(sm->thread != std::this_thread::get_id());
+	REQUIRE(executor.shard_of(h) == 1);
+}
+
+TEST_CASE("Machines migrate between shards at a quiescent point", "[hsm][executor]") {
+	Machine sm;
+	sm.start(0, build);
+	Executor executor(2);
+	auto     h = executor.add(sm, 0);
+
+	executor.post(h, Work{}).wait();
+	const std::thread::id before = sm->thread;
+
+	executor.migrate(h, 1);
+	REQUIRE(eventually([&] { return executor.shard_of(h) == 1; }));
+	executor.post(h, Work{}).wait();
+
+	REQUIRE(sm->thread != before);
+	REQUIRE(sm->count == 2);
+	REQUIRE(executor.migrations() == 1);
+}
+
+TEST_CASE("Rebalancing moves machines off the busiest shard", "[hsm][executor]") {
+	std::vector<std::unique_ptr<Machine>> fleet;
+	Executor                              executor(2);
+	std::vector<Executor::Handle>         handles;
+	for (int i = 0; i < 4; ++i) {
+		fleet.emplace_back(new Machine());
+		fleet.back()->start(0, build);
+		handles.push_back(executor.add(*fleet.back(), 0));
+	}
+
+	for (int round = 0; round < 10; ++round) {
+		for (auto h : handles) { executor.post(h, Work{}).wait(); }
+	}
+	REQUIRE(executor.rebalance() > 0);
+	REQUIRE(eventually([&] { return executor.migrations() > 0; }));
+
+	std::size_t moved = 0;
+	for (auto h : handles) { moved += executor.shard_of(h); }
+	REQUIRE(moved > 0);
+	REQUIRE(moved < handles.size());
+	REQUIRE(executor.rebalance() == 0);
+}
+
+TEST_CASE("Tenants share a shard by weight", "[hsm][executor]") {
+	struct Order {
+		std::vector<int> tenants;
+	} order;
+	std::atomic<bool> entered{false}, release{false};
+
+	auto tagged = [&order](int tenant) {
+		return [&order, tenant](Scope &s) {
+			s.state(0).handle([&order, tenant](Machine &, const BaseEvent &) {
+				order.tenants.push_back(tenant);
+				return hsm::Result::Done;
+			});
+		};
+	};
+
+	Machine gate, a, b;
+	gate.start(0, [&](Scope &s) {
+		s.state(0).handle([&](Machine &, const BaseEvent &) {
+			entered = true;
+			while (!release) { std::this_thread::yield(); }
+			return hsm::Result::Done;
+		});
+	});
+	a.start(0, tagged(1));
+	b.start(0, tagged(2));
+
+	Executor executor(1);
+	auto     hg = executor.add(gate, 0);
+	auto     ha = executor.add(a, 0, executor.add_tenant(1));
+	auto     hb = executor.add(b, 0, executor.add_tenant(3));
+
+	// Hold the shard while both tenants queue up a backlog
+	executor.post(hg, Work{});
+	REQUIRE(eventually([&] { return entered.load(); }));
+	std::vector<Machine::Ticket> tickets;
+	for (int i = 0; i < 80; ++i) {
+		tickets.push_back(executor.post(ha, Work{}));
+		tickets.push_back(executor.post(hb, Work{}));
+	}
+	release = true;
+	for (auto &t : tickets) { t.wait(); }
+
+	REQUIRE(order.tenants.size() == 160);
+	const long heavy = std::count(order.tenants.begin(), order.tenants.begin() + 64, 2);
+	REQUIRE(heavy == 48);
+}
+
+TEST_CASE("Lookahead prefetch leaves results unchanged", "[hsm][executor]") {
+	std::vector<std::unique_ptr<Machine>> fleet;
+	for (int i = 0; i < 64; ++i) {
+		fleet.emplace_back(new Machine());
+		fleet.back()->start(0, build);
+	}
+	Executor executor(1);
+	executor.lookahead(4);
+	std::vector<Executor::Handle> handles;
+	for (auto &sm : fleet) { handles.push_back(executor.add(*sm, 0)); }
+
+	std::vector<Machine::Ticket> tickets;
+	for (int round = 0; round < 3; ++round) {
+		for (auto h : handles) { tickets.push_back(executor.post(h, Work{})); }
+	}
+	for (auto &t : tickets) { REQUIRE(t.handled()); }
+	for (auto &sm : fleet) { REQUIRE((*sm)->count == 3); }
+}
+
+TEST_CASE("Executor rejects invalid shards", "[hsm][executor]") {
+	REQUIRE_THROWS_AS(Executor(0), std::invalid_argument);
+
+	Machine sm;
+	sm.start(0, build);
+	Executor executor(1);
+	REQUIRE_THROWS_AS(executor.add(sm, 1), std::invalid_argument);
+	REQUIRE_THROWS_AS(executor.add(sm, 0, 1), std::invalid_argument);
+	REQUIRE_THROWS_AS(executor.add_tenant(0), std::invalid_argument);
+}
+
+TEST_CASE("Shutdown runs what handlers post to other shards", "[hsm][executor]") {
+	Machine                   a;
+	Machine                   b;
+	std::unique_ptr<Executor> executor(new Executor(2));
+	Executor *const           relay_to = executor.get();  // Still valid while `reset()` destroys it
+	Executor::Handle          ha       = nullptr;
+	Executor::Handle          hb       = nullptr;
+	std::atomic<int>          hops{0};
+
+	// Each hop is posted to the machine on the other shard, so neither shard is idle for good until the last one
+	const auto relay = [&](Machine &sm, const BaseEvent &ev) {
+		const int left = static_cast<const Hop &>(ev).left;
+		hops++;
+		if (left > 0) { relay_to->post(&sm == &a ? hb : ha, Hop(left - 1)); }
+		return hsm::Result::Done;
+	};
+	a.start(0, [&](Scope &s) { s.state(0).handle(relay); });
+	b.start(0, [&](Scope &s) { s.state(0).handle(relay); });
+	ha = executor->add(a, 0);
+	hb = executor->add(b, 1);
+
+	Machine::Ticket first = executor->post(ha, Hop(500));
+	executor.reset();
+	REQUIRE(hops == 501);
+	REQUIRE(first.handled());
+}
+
+TEST_CASE("A throwing handler fails only its own event", "[hsm][executor]") {
+	Machine sm;
+	sm.start(0, [](Scope &s) {
+		s.state(0).handle([](Machine &sm, const BaseEvent &ev) {
+			return hsm::match(sm, ev)
+				.on<Boom>([](Machine &, const Boom &) -> hsm::Result { throw std::runtime_error("handler failed"); })
+				.on<Work>([](Machine &sm, const Work &) {
+					sm->count++;
+					return hsm::Result::Done;
+				});
+		});
+	});
+	Executor executor(1);
+	auto     h = executor.add(sm, 0);
+
+	Machine::Ticket boom = executor.post(h, Boom{});
+	Machine::Ticket work = executor.post(h, Work{});
+	REQUIRE_FALSE(boom.handled());
+	REQUIRE(work.handled());
+	REQUIRE(sm->count == 1);
+	REQUIRE(executor.failures() == 1);
+	REQUIRE(executor.post(h, Work{}).handled());
+}
+
+TEST_CASE("A throwing handler leaves the machine idle for the next post", "[hsm][executor]") {
+	Machine sm;
+	sm.start(0, [](Scope &s) {
+		s.state(0).handle([](Machine &sm, const BaseEvent &ev) {
+			return hsm::match(sm, ev)
+				.on<Boom>([](Machine &sm, const Boom &) -> hsm::Result {
+					sm.transition(1);
+					sm.dispatch(Work{});
+					throw std::runtime_error("handler failed");
+				})
+				.on<Work>([](Machine &sm, const Work &) {
+					sm->count++;
+					return hsm::Result::Done;
+				});
+		});
+		s.state(1).on_entry([](Machine &sm) { sm->count += 100; });
+	});
+
+	Machine::Ticket boom = sm.post(Boom{});
+	Machine::Ticket work = sm.post(Work{});
+	std::size_t     resolved = 0;
+	REQUIRE_THROWS_AS(sm.drain(8, resolved), std::runtime_error);
+	REQUIRE(resolved == 1);
+	REQUIRE(boom.ready());
+	REQUIRE_FALSE(boom.handled());
+	REQUIRE_FALSE(work.ready());
+
+	REQUIRE(sm.drain() == 1);
+	REQUIRE(work.handled());
+	REQUIRE(work.state() == 0);
+	REQUIRE(sm.handled());
+	REQUIRE(sm.current_state_id() == 0);
+	REQUIRE(sm->count == 1);
+
+	// Idle again, so edits and transitions take effect right away
+	sm.insert([](Scope &s) { s.state(2); });
+	sm.transition(2);
+	REQUIRE(sm.current_state_id() == 2);
+}
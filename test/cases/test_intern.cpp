@@ -0,0 +1,129 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Next : BaseEvent {};
+
+struct NamedTraits {
+	using StateID = std::string;
+	using Event   = BaseEvent;
+	struct Context {
+		std::vector<hsm::StateRef> cycle;  // Resolved once from configuration
+		std::size_t                at = 0;
+	};
+};
+
+using Machine = hsm::Machine<NamedTraits>;
+using Scope   = hsm::Scope<NamedTraits>;
+
+// Stand-in for states read from a configuration file
+const std::vector<std::string> config = {"idle", "warming", "serving", "draining"};
+
+void build(Scope &s) {
+	s.state("app").with([](Scope &s) {
+		for (const auto &name : config) {
+			s.state(name).handle([](Machine &sm, const BaseEvent &) {
+				sm->at = (sm->at + 1) % sm->cycle.size();
+				sm.transition(sm->cycle[sm->at]);
+				return hsm::Result::Done;
+			});
+		}
+	});
+}
+
+}  // namespace
+
+TEST_CASE("Interned string IDs drive transitions by index", "[hsm][intern]") {
+	Machine sm;
+	sm.start("idle", build);
+	for (const auto &name : config) { sm->cycle.push_back(sm.intern(name)); }
+
+	REQUIRE(sm.active(sm.intern("app")));
+	REQUIRE(sm.active(sm->cycle[0]));
+	for (int i = 0; i < 6; ++i) { sm.dispatch(Next{}); }
+	REQUIRE(sm.current_state_id() == "serving");
+	REQUIRE(sm.current_state()->index() == sm->cycle[2].index);
+	REQUIRE_FALSE(sm.active(sm->cycle[0]));
+
+	sm.transition(sm->cycle[3]);
+	REQUIRE(sm.current_state_id() == "draining");
+	REQUIRE_THROWS_AS(sm.intern("missing"), std::invalid_argument);
+}
+
+TEST_CASE("Refs to removed states fail like unknown IDs", "[hsm][intern]") {
+	Machine sm;
+	sm.start("idle", build);
+	const hsm::StateRef draining = sm.intern("draining");
+
+	sm.remove("draining");
+	REQUIRE_THROWS_AS(sm.transition(draining), std::runtime_error);
+
+	sm.insert("app", [](Scope &s) { s.state("draining"); });
+	const hsm::StateRef again = sm.intern("draining");
+	REQUIRE(again != draining);
+	sm.transition(again);
+	REQUIRE(sm.current_state_id() == "draining");
+}
+
+TEST_CASE("Refs from before a failed restart fail like unknown IDs", "[hsm][intern]") {
+	Machine sm;
+	sm.start("idle", build);
+	const hsm::StateRef serving = sm.intern("serving");
+	sm.stop();
+
+	auto duplicate = [](Scope &s) {
+		s.state("idle");
+		s.state("idle");
+	};
+	REQUIRE_THROWS_AS(sm.start("idle", duplicate), std::invalid_argument);
+	REQUIRE_THROWS_AS(sm.transition(serving), std::runtime_error);
+	REQUIRE_FALSE(sm.active(serving));
+
+	REQUIRE_THROWS_AS(sm.start("idle", [](Scope &) { throw std::runtime_error("build failed"); }), std::runtime_error);
+	REQUIRE_THROWS_AS(sm.transition(serving), std::runtime_error);
+}
+
+TEST_CASE("Duplicate string IDs are found once sorted", "[hsm][intern]") {
+	Machine sm;
+	REQUIRE_THROWS_AS(sm.start("a",
+							   [](Scope &s) {
+								   s.state("a");
+								   s.state("b").with([](Scope &s) { s.state("a"); });
+							   }),
+					  std::invalid_argument);
+
+	sm.start("a", [](Scope &s) { s.state("a"); });
+	REQUIRE_THROWS_AS(sm.insert("a",
+								[](Scope &s) {
+									s.state("x");
+									s.state("x");
+								}),
+					  std::invalid_argument);
+	REQUIRE_THROWS_AS(sm.insert("a", [](Scope &s) { s.state("a"); }), std::invalid_argument);
+
+	sm.insert("a", [](Scope &s) { s.state("x"); });
+	sm.transition(sm.intern("x"));
+	REQUIRE(sm.current_state_id() == "x");
+}
+
+TEST_CASE("Refs survive edits to other subtrees", "[hsm][intern]") {
+	Machine sm;
+	sm.start("idle", build);
+	const hsm::StateRef serving = sm.intern("serving");
+
+	sm.insert([](Scope &s) { s.state("maintenance").with([](Scope &s) { s.state("backup"); }); });
+	const hsm::StateRef backup = sm.intern("backup");
+	sm.remove("maintenance");
+	REQUIRE_THROWS_AS(sm.transition(backup), std::runtime_error);
+
+	sm.transition(serving);
+	REQUIRE(sm.current_state_id() == "serving");
+}
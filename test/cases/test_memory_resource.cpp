@@ -0,0 +1,136 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "catch.hpp"
+#include "hsm/hugepage.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Nested : BaseEvent {};
+struct Leaf : BaseEvent {};
+
+struct PoolTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int leaves = 0;
+	};
+};
+
+using Machine = hsm::Machine<PoolTraits>;
+using Scope   = hsm::Scope<PoolTraits>;
+
+class CountingResource : public hsm::MemoryResource {
+public:
+	std::size_t live   = 0;
+	std::size_t allocs = 0;
+
+	void *allocate(std::size_t bytes, std::size_t align) override {
+		++live;
+		++allocs;
+		return hsm::default_resource()->allocate(bytes, align);
+	}
+	void deallocate(void *p, std::size_t bytes, std::size_t align) override {
+		--live;
+		hsm::default_resource()->deallocate(p, bytes, align);
+	}
+};
+
+class ArenaResource : public hsm::PoolResource {
+public:
+	int refills = 0;
+
+protected:
+	void *refill(std::size_t min_bytes, std::size_t &got) override {
+		if (refills++ || min_bytes > sizeof(buffer_)) { return nullptr; }
+		got = sizeof(buffer_);
+		return buffer_;
+	}
+
+private:
+	alignas(16) char buffer_[4096];
+};
+
+void build(Scope &s) {
+	s.state(0).handle([](Machine &sm, const BaseEvent &ev) {
+		return hsm::match(sm, ev)
+			.on<Nested>([](Machine &sm, const Nested &) {
+				sm.dispatch(Leaf{});
+				return hsm::Result::Done;
+			})
+			.on<Leaf>([](Machine &sm, const Leaf &) {
+				sm->leaves++;
+				return hsm::Result::Done;
+			});
+	});
+	s.state(1);
+}
+
+}  // namespace
+
+TEST_CASE("Machine storage is drawn from its resource", "[hsm][resource]") {
+	CountingResource resource;
+	{
+		Machine sm;
+		sm.use_resource(resource);
+		sm.start(0, build);
+
+		const std::size_t after_start = resource.allocs;
+		REQUIRE(after_start >= 3);  // Two states plus registry storage
+
+		sm.dispatch(Nested{});
+		REQUIRE(sm->leaves == 1);
+		REQUIRE(resource.allocs > after_start);  // The queued event
+	}
+	REQUIRE(resource.live == 0);
+}
+
+TEST_CASE("Resource cannot change while running", "[hsm][resource]") {
+	CountingResource resource;
+	Machine          sm;
+	sm.start(0, build);
+	REQUIRE_THROWS_AS(sm.use_resource(resource), std::logic_error);
+}
+
+TEST_CASE("Pool resource recycles blocks by size class", "[hsm][resource]") {
+	ArenaResource pool;
+
+	void *a = pool.allocate(24, 8);
+	void *b = pool.allocate(32, 8);
+	REQUIRE(a != b);
+	REQUIRE(reinterpret_cast<std::uintptr_t>(a) % hsm::PoolResource::alignment == 0);
+
+	pool.deallocate(a, 24, 8);
+	REQUIRE(pool.allocate(17, 8) == a);
+
+	SECTION("Exhaustion raises bad_alloc") { REQUIRE_THROWS_AS(pool.allocate(8192, 8), std::bad_alloc); }
+}
+
+TEST_CASE("Over-aligned requests get their alignment", "[hsm][resource]") {
+	ArenaResource pool;
+	for (std::size_t align : {std::size_t(32), std::size_t(64), std::size_t(4096)}) {
+		void *a = hsm::default_resource()->allocate(40, align);
+		void *b = pool.allocate(40, align);
+		REQUIRE(reinterpret_cast<std::uintptr_t>(a) % align == 0);
+		REQUIRE(reinterpret_cast<std::uintptr_t>(b) % align == 0);
+		hsm::default_resource()->deallocate(a, 40, align);
+		pool.deallocate(b, 40, align);
+	}
+}
+
+TEST_CASE("Huge page resource hosts machines", "[hsm][resource]") {
+	hsm::HugePageResource resource(1);
+	REQUIRE(resource.backing() == hsm::HugePageResource::Backing::None);
+	{
+		auto sm = hsm::make_owned<Machine>(resource);
+		sm->use_resource(resource);
+		sm->start(0, build);
+		sm->dispatch(Nested{});
+		REQUIRE((*sm)->leaves == 1);
+	}
+	REQUIRE(resource.backing() != hsm::HugePageResource::Backing::None);
+	REQUIRE(resource.mapped() == hsm::HugePageResource::huge_page_size);
+}
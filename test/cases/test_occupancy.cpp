@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/occupancy.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Advance : BaseEvent {};
+
+struct OccupancyTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int id = 0;
+	};
+};
+
+using Machine   = hsm::Machine<OccupancyTraits>;
+using Scope     = hsm::Scope<OccupancyTraits>;
+using Occupancy = hsm::OccupancyIndex<OccupancyTraits>;
+
+enum { CONNECTING, AUTH, OPEN };
+
+template <int Next>
+hsm::Result advance(Machine &sm, const BaseEvent &) {
+	sm.transition(Next);
+	return hsm::Result::Done;
+}
+
+void build(Scope &s) {
+	s.state(CONNECTING).handle(advance<AUTH>);
+	s.state(AUTH).handle(advance<OPEN>);
+	s.state(OPEN).handle(advance<CONNECTING>);
+}
+
+}  // namespace
+
+TEST_CASE("Occupancy follows transitions", "[hsm][occupancy]") {
+	std::vector<std::unique_ptr<Machine>> fleet;
+	Occupancy                             index;
+	std::vector<Occupancy::Handle>        handles;
+	for (int i = 0; i < 10; ++i) {
+		fleet.emplace_back(new Machine());
+		fleet.back()->context().id = i;
+		fleet.back()->start(CONNECTING, build);
+		handles.push_back(index.track(*fleet.back()));
+	}
+	for (int i = 0; i < 4; ++i) { fleet[i]->dispatch(Advance{}); }
+	fleet[0]->dispatch(Advance{});
+
+	REQUIRE(index.size() == 10);
+	REQUIRE(index.count(CONNECTING) == 6);
+	REQUIRE(index.count(AUTH) == 3);
+	REQUIRE(index.count(OPEN) == 1);
+
+	std::vector<int> stuck;
+	index.for_each(AUTH, [&](Machine &sm) { stuck.push_back(sm->id); });
+	std::sort(stuck.begin(), stuck.end());
+	REQUIRE(stuck == std::vector<int>{1, 2, 3});
+
+	SECTION("Histogram covers every state seen") {
+		std::size_t total = 0;
+		for (std::size_t n : index.histogram()) { total += n; }
+		REQUIRE(total == 10);
+	}
+
+	SECTION("Untracked machines leave the index") {
+		index.untrack(handles[1]);
+		fleet[1]->dispatch(Advance{});
+		REQUIRE(index.size() == 9);
+		REQUIRE(index.count(AUTH) == 2);
+		REQUIRE(index.count(OPEN) == 1);
+
+		index.track(*fleet[1]);
+		REQUIRE(index.count(OPEN) == 2);
+	}
+}
+
+namespace {
+
+enum { DOWN = 10, UP, AUTHENTICATING, READY };
+
+void build_nested(Scope &s) {
+	s.state(DOWN).handle(advance<AUTHENTICATING>);
+	s.state(UP).with([](Scope &s) {
+		s.state(AUTHENTICATING).handle(advance<READY>);
+		s.state(READY).handle(advance<DOWN>);
+	});
+}
+
+}  // namespace
+
+TEST_CASE("Occupancy counts every state on the active path", "[hsm][occupancy]") {
+	std::vector<std::unique_ptr<Machine>> fleet;
+	Occupancy                             index;
+	std::vector<Occupancy::Handle>        handles;
+	for (int i = 0; i < 6; ++i) {
+		fleet.emplace_back(new Machine());
+		fleet.back()->context().id = i;
+		fleet.back()->start(DOWN, build_nested);
+		handles.push_back(index.track(*fleet.back()));
+	}
+	for (int i = 0; i < 4; ++i) { fleet[i]->dispatch(Advance{}); }
+	for (int i = 0; i < 2; ++i) { fleet[i]->dispatch(Advance{}); }
+
+	const hsm::StateRef up = fleet[0]->intern(UP);
+	REQUIRE(index.count(DOWN) == 2);
+	REQUIRE(index.count(AUTHENTICATING) == 2);
+	REQUIRE(index.count(READY) == 2);
+	REQUIRE(index.count(UP) == 4);
+	REQUIRE(index.count(up) == 4);
+
+	std::vector<int> online;
+	index.for_each(up, [&](Machine &sm) { online.push_back(sm->id); });
+	std::sort(online.begin(), online.end());
+	REQUIRE(online == std::vector<int>{0, 1, 2, 3});
+
+	SECTION("Moving between substates keeps the parent's membership") {
+		fleet[2]->dispatch(Advance{});
+		REQUIRE(index.count(AUTHENTICATING) == 1);
+		REQUIRE(index.count(READY) == 3);
+		REQUIRE(index.count(UP) == 4);
+	}
+
+	SECTION("Leaving the composite leaves every level") {
+		fleet[0]->dispatch(Advance{});
+		index.untrack(handles[1]);
+		REQUIRE(index.count(UP) == 2);
+		REQUIRE(index.count(READY) == 0);
+		REQUIRE(index.count(DOWN) == 3);
+
+		online.clear();
+		index.for_each(UP, [&](Machine &sm) { online.push_back(sm->id); });
+		std::sort(online.begin(), online.end());
+		REQUIRE(online == std::vector<int>{2, 3});
+	}
+}
+
+TEST_CASE("Occupancy requires started machines", "[hsm][occupancy]") {
+	Machine   sm;
+	Occupancy index;
+	REQUIRE_THROWS_AS(index.track(sm), std::logic_error);
+	REQUIRE(index.count(AUTH) == 0);
+}
+
+TEST_CASE("Stopped machines leave the occupancy counts", "[hsm][occupancy]") {
+	Machine   a, b;
+	Occupancy index;
+	a.start(CONNECTING, build);
+	b.start(CONNECTING, build);
+	Occupancy::Handle ha = index.track(a);
+	Occupancy::Handle hb = index.track(b);
+
+	a.dispatch(Advance{});
+	a.stop();
+	REQUIRE(index.size() == 1);
+	REQUIRE(index.count(AUTH) == 0);
+	REQUIRE(index.count(CONNECTING) == 1);
+	REQUIRE_THROWS_AS(index.track(a), std::logic_error);
+
+	SECTION("A restarted machine counts again") {
+		a.start(OPEN, build);
+		REQUIRE(index.size() == 2);
+		REQUIRE(index.count(OPEN) == 1);
+	}
+
+	SECTION("Untracking a stopped machine keeps the totals") {
+		index.untrack(ha);
+		REQUIRE(index.size() == 1);
+	}
+
+	index.untrack(hb);
+	REQUIRE(index.count(CONNECTING) == 0);
+}
+
+TEST_CASE("A machine stopping on entry leaves the occupancy counts", "[hsm][occupancy]") {
+	enum { FINAL = OPEN + 1 };
+	Machine   sm;
+	Occupancy index;
+	sm.start(CONNECTING, [](Scope &s) {
+		s.state(CONNECTING).handle(advance<FINAL>);
+		s.state(FINAL).on_entry([](Machine &sm) { sm.stop(); });
+	});
+	Occupancy::Handle h = index.track(sm);
+	sm.dispatch(Advance{});
+
+	REQUIRE(sm.terminated());
+	REQUIRE(index.size() == 0);
+	REQUIRE(index.count(FINAL) == 0);
+	REQUIRE(index.count(CONNECTING) == 0);
+	index.untrack(h);
+	REQUIRE(index.size() == 0);
+}
+
+TEST_CASE("A refused registration leaves the index unchanged", "[hsm][occupancy]") {
+	Occupancy index;
+	Machine   sm;
+	bool      refused = false;
+	sm.start(CONNECTING, [&](Scope &s) {
+		s.state(CONNECTING).handle([&](Machine &sm, const BaseEvent &) {
+			// Observers cannot be added while dispatching
+			try {
+				index.track(sm);
+			} catch (const std::logic_error &) { refused = true; }
+			return hsm::Result::Done;
+		});
+	});
+	sm.dispatch(Advance{});
+
+	REQUIRE(refused);
+	REQUIRE(index.size() == 0);
+	REQUIRE(index.count(CONNECTING) == 0);
+
+	Occupancy::Handle h = index.track(sm);
+	REQUIRE(index.count(CONNECTING) == 1);
+	index.untrack(h);
+}
@@ -0,0 +1,156 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Go : BaseEvent {};
+struct Ignored : BaseEvent {};
+struct Stray : BaseEvent {};
+
+struct PostTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int gos = 0;
+	};
+};
+
+using Machine = hsm::Machine<PostTraits>;
+using Scope   = hsm::Scope<PostTraits>;
+
+void build(Scope &s) {
+	s.state(0).accepts<Go, Ignored>().handle([](Machine &sm, const BaseEvent &ev) {
+		return hsm::match(sm, ev)
+			.on<Go>([](Machine &sm, const Go &) {
+				sm->gos++;
+				sm.transition(1);
+				return hsm::Result::Done;
+			})
+			.on<Ignored>([](Machine &, const Ignored &) { return hsm::Result::Pass; });
+	});
+	s.state(1).accepts<Go>().handle([](Machine &sm, const BaseEvent &) {
+		sm->gos++;
+		sm.transition(0);
+		return hsm::Result::Done;
+	});
+}
+
+}  // namespace
+
+TEST_CASE("Posted events resolve their tickets on drain", "[hsm][post]") {
+	Machine sm;
+	sm.start(0, build);
+
+	Machine::Ticket go      = sm.post(Go{});
+	Machine::Ticket ignored = sm.post(Ignored{});
+	REQUIRE(go.valid());
+	REQUIRE_FALSE(go.ready());
+	REQUIRE(sm->gos == 0);
+
+	REQUIRE(sm.drain() == 2);
+	REQUIRE(go.ready());
+	REQUIRE(go.handled());
+	REQUIRE(go.state() == 1);
+	REQUIRE_FALSE(ignored.handled());
+	REQUIRE(ignored.state() == 1);
+	REQUIRE(sm.drain() == 0);
+}
+
+TEST_CASE("Drain can be bounded", "[hsm][post]") {
+	Machine sm;
+	sm.start(0, build);
+
+	std::vector<Machine::Ticket> tickets;
+	for (int i = 0; i < 5; ++i) { tickets.push_back(sm.post(Go{})); }
+
+	REQUIRE(sm.drain(2) == 2);
+	REQUIRE(tickets[1].ready());
+	REQUIRE_FALSE(tickets[2].ready());
+	REQUIRE(sm->gos == 2);
+
+	// The rest of the bounded batch, then one fresh batch
+	tickets.push_back(sm.post(Go{}));
+	REQUIRE(sm.drain(10) == 4);
+	REQUIRE(sm.drain() == 0);
+	REQUIRE(sm->gos == 6);
+}
+
+TEST_CASE("Posts no state accepts resolve immediately", "[hsm][post]") {
+	Machine sm;
+	sm.start(0, build);
+
+	Machine::Ticket stray = sm.post(Stray{});
+	REQUIRE(stray.ready());
+	REQUIRE_FALSE(stray.handled());
+	REQUIRE(sm.drain() == 0);
+	REQUIRE(sm.stats().unhandleable == 1);
+}
+
+TEST_CASE("Tickets can be awaited from the posting thread", "[hsm][post]") {
+	Machine sm;
+	sm.start(0, build);
+
+	std::vector<bool> results;
+	std::thread       poster([&] {
+		for (int i = 0; i < 100; ++i) {
+			Machine::Ticket t = sm.post(Go{});
+			results.push_back(t.handled());
+		}
+	});
+
+	while (sm->gos < 100) {
+		if (sm.drain() == 0) { std::this_thread::yield(); }
+	}
+	poster.join();
+
+	REQUIRE(sm->gos == 100);
+	REQUIRE(results == std::vector<bool>(100, true));
+}
+
+TEST_CASE("Ticket wait_for times out while undrained", "[hsm][post]") {
+	Machine sm;
+	sm.start(0, build);
+
+	Machine::Ticket t = sm.post(Go{});
+	REQUIRE_FALSE(t.wait_for(std::chrono::milliseconds(1)));
+	sm.drain();
+	REQUIRE(t.wait_for(std::chrono::milliseconds(1)));
+}
+
+TEST_CASE("Tickets without a post read as refused", "[hsm][post]") {
+	Machine sm;
+	sm.start(0, build);
+
+	Machine::Ticket empty;
+	REQUIRE_FALSE(empty.valid());
+	REQUIRE(empty.ready());
+	REQUIRE(empty.refused());
+	REQUIRE_FALSE(empty.handled());
+	REQUIRE(empty.state() == 0);
+
+	Machine::Ticket posted = sm.post(Go{});
+	Machine::Ticket moved  = std::move(posted);
+	REQUIRE(posted.wait_for(std::chrono::milliseconds(0)));
+	REQUIRE(posted.refused());
+	sm.drain();
+	REQUIRE(moved.handled());
+}
+
+TEST_CASE("Undrained posts are released with the machine", "[hsm][post]") {
+	struct Note : BaseEvent {
+		std::string text = std::string(64, 'x');  // Owns heap memory a leak checker would report
+	};
+	Machine sm;
+	sm.start(0, [](Scope &s) { s.state(0).handle([](Machine &, const BaseEvent &) { return hsm::Result::Done; }); });
+	for (int i = 0; i < 8; ++i) { sm.post(Note{}); }
+	REQUIRE(sm.drain(3) == 3);
+	for (int i = 0; i < 8; ++i) { sm.post(Note{}); }
+}
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <deque>
+#include <thread>
+
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Toggle : BaseEvent {};
+struct Status : BaseEvent {
+	mutable int  state = -1;
+	mutable long a     = 0;
+	mutable long b     = 0;
+};
+struct Unknown : BaseEvent {};
+
+struct QueryTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	static constexpr bool ConcurrentQueries = true;
+	// Query handlers read the context while the owner writes it, so the fields they see are relaxed atomics
+	struct Context {
+		std::atomic<long> a{0};
+		std::atomic<long> b{0};
+	};
+};
+
+using Machine = hsm::Machine<QueryTraits>;
+using Scope   = hsm::Scope<QueryTraits>;
+
+struct PlainTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {};
+};
+
+struct OptInTraits : PlainTraits {
+	static constexpr bool ConcurrentQueries = true;
+};
+
+template <int Self>
+hsm::Result report(const Machine &sm, const BaseEvent &ev) {
+	const auto *status = dynamic_cast<const Status *>(&ev);
+	if (!status) { return hsm::Result::Pass; }
+	status->state = Self;
+	status->a     = sm->a.load(std::memory_order_relaxed);
+	status->b     = sm->b.load(std::memory_order_relaxed);
+	return hsm::Result::Done;
+}
+
+template <int Next>
+hsm::Result toggle(Machine &sm, const BaseEvent &) {
+	sm->a.store(sm->a.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	sm->b.store(sm->b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	sm.transition(Next);
+	return hsm::Result::Done;
+}
+
+void build(Scope &s) {
+	s.state(0).query(report<0>).handle(toggle<1>);
+	s.state(1).query(report<1>).handle(toggle<0>);
+}
+
+}  // namespace
+
+TEST_CASE("Queries run const handlers on the active path", "[hsm][query]") {
+	Machine sm;
+	sm.start(0, build);
+	sm.dispatch(Toggle{});
+
+	Status status;
+	REQUIRE(sm.query(status));
+	REQUIRE(status.state == 1);
+	REQUIRE(status.a == 1);
+	REQUIRE_FALSE(sm.query(Unknown{}));
+}
+
+TEST_CASE("Queries from other threads see consistent steps", "[hsm][query]") {
+	Machine sm;
+	sm.start(0, build);
+
+	std::atomic<bool> done{false};
+	std::atomic<long> torn{0};
+	std::atomic<long> answered{0};
+	std::thread       reader([&] {
+		while (!done.load()) {
+			Status status;
+			if (!sm.query(status)) { continue; }
+			// The state flips with every step, so it always matches the parity of the counters
+			if (status.a != status.b || status.a % 2 != status.state) { ++torn; }
+			++answered;
+		}
+	});
+
+	for (int i = 0; i < 20000 || answered < 100; ++i) {
+		sm.dispatch(Toggle{});
+		if (i % 64 == 0) { std::this_thread::yield(); }
+	}
+	done = true;
+	reader.join();
+
+	REQUIRE(torn == 0);
+	REQUIRE(answered > 0);
+}
+
+TEST_CASE("Queries keep removed states alive until they finish", "[hsm][query]") {
+	Machine sm;
+	sm.start(0, build);
+
+	std::atomic<bool> done{false};
+	std::atomic<long> answered{0};
+	std::thread       reader([&] {
+		while (!done.load()) {
+			Status status;
+			if (sm.query(status)) { ++answered; }
+		}
+	});
+
+	// The reader may still be inside state 2 when the owner leaves and frees it
+	for (int i = 0; i < 2000 || answered < 100; ++i) {
+		sm.insert([](Scope &s) { s.state(2).query(report<2>); });
+		sm.transition(2);
+		sm.transition(0);
+		sm.remove(2);
+	}
+	done = true;
+	reader.join();
+
+	REQUIRE(answered > 0);
+	REQUIRE(sm.current_state_id() == 0);
+}
+
+TEST_CASE("Machines that do not opt into queries stay small", "[hsm][query]") {
+	// Queries, limits, filters, completions and observers live behind one pointer until used, so the rest of a
+	// plain machine is the root state, the event queue and a fixed set of words
+	using Plain = hsm::Machine<PlainTraits>;
+	const std::size_t core = sizeof(Plain) - sizeof(PlainTraits::Context) - sizeof(hsm::LambdaState<PlainTraits>) - sizeof(std::deque<void *>);
+	REQUIRE(core <= 19 * sizeof(void *));
+	REQUIRE(sizeof(Plain) == sizeof(hsm::Machine<OptInTraits>));
+	REQUIRE(sizeof(hsm::State<PlainTraits>) <= 5 * sizeof(void *));
+
+	Plain sm;
+	sm.start(0, [](hsm::Scope<PlainTraits> &s) { s.state(0).handle([](Plain &sm, const BaseEvent &) {
+		sm.transition(0);
+		return hsm::Result::Done;
+	}); });
+	sm.dispatch(Toggle{});
+	REQUIRE(sm.handled());
+	REQUIRE(sm.stats().rate_limited == 0);
+}
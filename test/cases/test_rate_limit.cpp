@@ -0,0 +1,118 @@
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Flood : BaseEvent {};
+struct Ping : BaseEvent {};
+
+struct LimitTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int floods = 0;
+		int pings  = 0;
+	};
+};
+
+using Machine = hsm::Machine<LimitTraits>;
+using Scope   = hsm::Scope<LimitTraits>;
+
+hsm::Result count(Machine &sm, const BaseEvent &ev) {
+	return hsm::match(sm, ev)
+		.on<Flood>([](Machine &sm, const Flood &) {
+			sm->floods++;
+			return hsm::Result::Done;
+		})
+		.on<Ping>([](Machine &sm, const Ping &) {
+			sm->pings++;
+			return hsm::Result::Done;
+		});
+}
+
+}  // namespace
+
+TEST_CASE("Machine-wide token bucket", "[hsm][rate_limit]") {
+	Machine sm;
+	sm.start(0, [](Scope &s) {
+		s.limit<Flood>(0.0, 3);
+		s.state(0).handle(count);
+	});
+
+	for (int i = 0; i < 10; ++i) { sm.dispatch(Flood{}); }
+	sm.dispatch(Ping{});
+
+	SECTION("Only the burst reaches the handler") {
+		REQUIRE(sm->floods == 3);
+		REQUIRE(sm.stats().rate_limited == 7);
+	}
+
+	SECTION("Other event types are unaffected") { REQUIRE(sm->pings == 1); }
+}
+
+TEST_CASE("Token bucket scoped to a subtree", "[hsm][rate_limit]") {
+	Machine sm;
+	sm.start(1, [](Scope &s) {
+		s.state(0).handle(count).with([](Scope &s) {
+			s.limit<Flood>(0.0, 1);
+			s.state(1);
+		});
+		s.state(2).handle(count);
+	});
+
+	sm.dispatch(Flood{});
+	sm.dispatch(Flood{});
+	REQUIRE(sm->floods == 1);
+	REQUIRE(sm.stats().rate_limited == 1);
+
+	sm.transition(2);
+	sm.dispatch(Flood{});
+	sm.dispatch(Flood{});
+	REQUIRE(sm->floods == 3);
+	REQUIRE(sm.stats().rate_limited == 1);
+}
+
+TEST_CASE("Token bucket declared through the state proxy", "[hsm][rate_limit]") {
+	Machine sm;
+	sm.start(1, [](Scope &s) {
+		s.state(0).handle(count).limit<Flood>(0.0, 2).with([](Scope &s) { s.state(1); });
+	});
+
+	for (int i = 0; i < 5; ++i) { sm.dispatch(Flood{}); }
+	REQUIRE(sm->floods == 2);
+	REQUIRE(sm.stats().rate_limited == 3);
+}
+
+TEST_CASE("Posted and dispatched events share a bucket", "[hsm][rate_limit]") {
+	int seen = 0;
+	Machine sm;
+	sm.start(0, [&seen](Scope &s) {
+		s.limit<BaseEvent>(0.0, 2);
+		s.state(0).handle([&seen](Machine &, const BaseEvent &) {
+			++seen;
+			return hsm::Result::Done;
+		});
+	});
+
+	sm.dispatch(BaseEvent{});
+	sm.post(BaseEvent{});
+	sm.post(BaseEvent{});
+	sm.drain();
+	sm.dispatch(BaseEvent{});
+
+	REQUIRE(seen == 2);
+	REQUIRE(sm.stats().rate_limited == 2);
+}
+
+TEST_CASE("Token bucket rejects invalid parameters", "[hsm][rate_limit]") {
+	Machine sm;
+	REQUIRE_THROWS_AS(sm.start(0,
+							   [](Scope &s) {
+								   s.limit<Flood>(1.0, 0.5);
+								   s.state(0);
+							   }),
+					  std::invalid_argument);
+}
@@ -0,0 +1,128 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/snapshot.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Tick : BaseEvent {};
+
+struct SnapshotTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		long        ticks = 0;
+		std::string status;
+	};
+};
+
+using Machine = hsm::Machine<SnapshotTraits>;
+using Scope   = hsm::Scope<SnapshotTraits>;
+
+struct View {
+	int         state = -1;
+	long        ticks = -1;
+	std::string status;
+};
+
+using Publisher = hsm::SnapshotPublisher<SnapshotTraits, View>;
+
+template <int Next>
+hsm::Result tick(Machine &sm, const BaseEvent &) {
+	sm->ticks++;
+	sm->status = "tick " + std::to_string(sm->ticks);
+	sm.transition(Next);
+	return hsm::Result::Done;
+}
+
+void build(Scope &s) {
+	s.state(0).handle(tick<1>);
+	s.state(1).handle(tick<0>);
+}
+
+void fill(const Machine &sm, View &v) {
+	v.state  = sm.current_state_id();
+	v.ticks  = sm->ticks;
+	v.status = sm->status;
+}
+
+}  // namespace
+
+TEST_CASE("Snapshots follow run-to-completion steps", "[hsm][snapshot]") {
+	Machine sm;
+	sm.start(0, build);
+	Publisher         publisher(sm, fill);
+	Publisher::Reader reader(publisher);
+
+	REQUIRE(reader.read().ticks == 0);
+	sm.dispatch(Tick{});
+	sm.dispatch(Tick{});
+	sm.dispatch(Tick{});
+
+	const View &v = reader.read();
+	REQUIRE(v.ticks == 3);
+	REQUIRE(v.state == 1);
+	REQUIRE(v.status == "tick 3");
+	REQUIRE(&reader.read() == &v);
+	REQUIRE(publisher.published() == 4);
+}
+
+TEST_CASE("Snapshot readers are limited to the declared count", "[hsm][snapshot]") {
+	Machine sm;
+	sm.start(0, build);
+	Publisher publisher(sm, fill, 2);
+
+	Publisher::Reader first(publisher);
+	{
+		Publisher::Reader second(publisher);
+		REQUIRE_THROWS_AS(Publisher::Reader(publisher), std::logic_error);
+	}
+	Publisher::Reader again(publisher);
+
+	// Pinned buffers stay intact while the owner keeps publishing into the spare ones
+	const View &held = first.read();
+	const View &also = again.read();
+	for (int i = 0; i < 10; ++i) { sm.dispatch(Tick{}); }
+	REQUIRE(held.ticks == 0);
+	REQUIRE(also.ticks == 0);
+	REQUIRE(first.read().ticks == 10);
+}
+
+TEST_CASE("Snapshots read from other threads are never torn", "[hsm][snapshot]") {
+	const int readers = 3;
+	Machine   sm;
+	sm.start(0, build);
+	Publisher publisher(sm, fill, readers);
+
+	std::atomic<bool>        done{false};
+	std::atomic<long>        torn{0};
+	std::atomic<long>        reads{0};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < readers; ++t) {
+		threads.emplace_back([&] {
+			Publisher::Reader reader(publisher);
+			long              last = 0;
+			while (!done.load()) {
+				const View &v = reader.read();
+				if (v.ticks < last || v.state != v.ticks % 2 || (v.ticks && v.status != "tick " + std::to_string(v.ticks))) { ++torn; }
+				last = v.ticks;
+				++reads;
+			}
+		});
+	}
+
+	for (int i = 0; i < 20000 || reads < 100 * readers; ++i) {
+		sm.dispatch(Tick{});
+		if (i % 64 == 0) { std::this_thread::yield(); }
+	}
+	done = true;
+	for (auto &t : threads) { t.join(); }
+
+	REQUIRE(torn == 0);
+}
@@ -0,0 +1,195 @@
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/store.hpp"
+
+#include <unistd.h>
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Advance : BaseEvent {};
+
+struct Session {
+	int advances;
+	int entries;
+};
+
+struct StoreTraits {
+	using StateID        = int;
+	using Event          = BaseEvent;
+	using Context        = Session;
+	using ContextStorage = hsm::ExternalContext;
+};
+
+using Machine = hsm::Machine<StoreTraits>;
+using Scope   = hsm::Scope<StoreTraits>;
+using Store   = hsm::FleetStore<StoreTraits>;
+
+template <int Next>
+hsm::Result advance(Machine &sm, const BaseEvent &) {
+	sm->advances++;
+	sm.transition(Next);
+	return hsm::Result::Done;
+}
+
+void build(Scope &s) {
+	s.state(0).name("Idle").on_entry([](Machine &sm) { sm->entries++; }).handle(advance<1>).with([](Scope &s) {
+		s.state(1).name("Auth").on_entry([](Machine &sm) { sm->entries++; }).handle(advance<2>);
+	});
+	s.state(2).name("Open").on_entry([](Machine &sm) { sm->entries++; }).handle(advance<0>);
+}
+
+// Unique empty file under $TMPDIR (or /tmp) so parallel or read-only test runs don't collide
+struct TempFile {
+	std::string path;
+	explicit TempFile(const char *prefix) {
+		const char *dir = std::getenv("TMPDIR");
+		path            = std::string(dir && *dir ? dir : "/tmp") + "/" + prefix + ".XXXXXX";
+		const int fd    = ::mkstemp(&path[0]);
+		REQUIRE(fd >= 0);
+		::close(fd);
+	}
+	~TempFile() { std::remove(path.c_str()); }
+};
+
+}  // namespace
+
+TEST_CASE("Fleet store survives a restart", "[hsm][store]") {
+	TempFile file("hsm_test_fleet");
+
+	{
+		Store                                 store(file.path, 8);
+		std::vector<std::unique_ptr<Machine>> fleet;
+		for (std::size_t i = 0; i < 3; ++i) {
+			fleet.emplace_back(new Machine(store.context(i)));
+			store.start(*fleet.back(), i, 0, build);
+			for (std::size_t n = 0; n < i; ++n) { fleet.back()->dispatch(Advance{}); }
+		}
+		REQUIRE(fleet[2]->current_state_id() == 2);
+	}
+
+	Store store(file.path, 1);
+	REQUIRE(store.capacity() == 8);
+	REQUIRE(store.in_use(2));
+	REQUIRE_FALSE(store.in_use(3));
+
+	std::vector<std::unique_ptr<Machine>> fleet;
+	for (std::size_t i = 0; i < 3; ++i) {
+		fleet.emplace_back(new Machine(store.context(i)));
+		store.resume(*fleet.back(), i, build);
+	}
+
+	SECTION("State and context are restored without running entry actions") {
+		REQUIRE(fleet[0]->current_state_id() == 0);
+		REQUIRE(fleet[1]->current_state_id() == 1);
+		REQUIRE(fleet[2]->current_state_id() == 2);
+		REQUIRE(fleet[1]->context().advances == 1);
+		REQUIRE(fleet[1]->context().entries == 2);
+		REQUIRE(fleet[2]->context().entries == 3);
+	}
+
+	SECTION("Resumed machines keep recording") {
+		fleet[1]->dispatch(Advance{});
+		REQUIRE(fleet[1]->current_state_id() == 2);
+		REQUIRE(fleet[1]->context().advances == 2);
+
+		Session kept{};
+		store.release(*fleet[0], 0, kept);
+		REQUIRE_FALSE(store.in_use(0));
+		REQUIRE_THROWS_AS(store.resume(*fleet[0], 0, build), std::logic_error);
+
+		// The released machine now runs on the caller's copy, not on the freed record
+		store.context(0).advances = 100;
+		fleet[0]->dispatch(Advance{});
+		REQUIRE(&fleet[0]->context() == &kept);
+		REQUIRE(kept.advances == 1);
+	}
+}
+
+TEST_CASE("Fleet store records stops made outside the store", "[hsm][store]") {
+	TempFile file("hsm_test_stop");
+	{
+		Store   store(file.path, 2);
+		Machine sm(store.context(1));
+		store.start(sm, 1, 0, build);
+		sm.dispatch(Advance{});
+		sm.stop();
+	}
+
+	Store   store(file.path, 2);
+	Machine sm(store.context(1));
+	store.resume(sm, 1, build);
+	REQUIRE(sm.terminated());
+	REQUIRE(sm.current_state_id() == 1);
+}
+
+TEST_CASE("Fleet store keeps the slot when start fails", "[hsm][store]") {
+	TempFile file("hsm_test_failed_start");
+	Store    store(file.path, 2);
+	{
+		Machine sm(store.context(0));
+		store.start(sm, 0, 0, build);
+		sm.dispatch(Advance{});
+	}
+
+	Machine sm(store.context(0));
+	REQUIRE_THROWS_AS(store.start(sm, 0, 42, build), std::invalid_argument);
+	REQUIRE(store.in_use(0));
+	REQUIRE(store.context(0).advances == 1);
+
+	Machine again(store.context(0));
+	store.resume(again, 0, build);
+	REQUIRE(again.current_state_id() == 1);
+}
+
+TEST_CASE("Fleet store leaves the machine's own context alone when start fails", "[hsm][store]") {
+	TempFile file("hsm_test_failed_bind");
+	Store    store(file.path, 2);
+	Session  own{};
+	Machine  sm(own);
+
+	SECTION("A running machine is rejected before it is bound") {
+		sm.start(0, build);
+		REQUIRE_THROWS_AS(store.start(sm, 1, 0, build), std::logic_error);
+		REQUIRE(sm.current_state_id() == 0);
+	}
+
+	SECTION("A throwing start rebinds the previous context") {
+		REQUIRE_THROWS_AS(store.start(sm, 1, 42, build), std::invalid_argument);
+		sm.start(0, build);
+	}
+
+	REQUIRE(&sm.context() == &own);
+	REQUIRE_FALSE(store.in_use(1));
+	sm.dispatch(Advance{});
+	REQUIRE(own.advances == 1);
+	REQUIRE(store.context(1).advances == 0);
+}
+
+TEST_CASE("Fleet store rejects foreign files", "[hsm][store]") {
+	TempFile file("hsm_test_foreign");
+	{
+		std::FILE *f = std::fopen(file.path.c_str(), "wb");
+		std::fputs("not a fleet store, just some bytes in a file", f);
+		std::fclose(f);
+	}
+	REQUIRE_THROWS_AS(Store(file.path, 4), std::runtime_error);
+}
+
+TEST_CASE("Fleet store rejects truncated files", "[hsm][store]") {
+	TempFile file("hsm_test_truncated");
+	{
+		Store   store(file.path, 8);
+		Machine sm(store.context(7));
+		store.start(sm, 7, 0, build);
+	}
+	REQUIRE(::truncate(file.path.c_str(), 128) == 0);
+	REQUIRE_THROWS_AS(Store(file.path, 8), std::runtime_error);
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/timer.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Timeout : BaseEvent {};
+
+struct TimerTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int timeouts = 0;
+	};
+};
+
+using Machine = hsm::Machine<TimerTraits>;
+using Scope   = hsm::Scope<TimerTraits>;
+using Wheel   = hsm::TimerWheel;
+using ms      = std::chrono::milliseconds;
+
+Wheel::TimePoint at(long long millis) { return Wheel::TimePoint(ms(millis)); }
+
+}  // namespace
+
+TEST_CASE("Timers fire within their window", "[hsm][timer]") {
+	Wheel            wheel;
+	std::vector<int> order;
+	wheel.schedule(at(100), at(100), [&] { order.push_back(1); });
+	wheel.schedule(at(40), at(60), [&] { order.push_back(2); });
+
+	SECTION("Nothing fires before the earliest point") {
+		REQUIRE(wheel.advance(at(39)) == 0);
+		REQUIRE(wheel.next_wakeup() >= at(40));
+		REQUIRE(wheel.next_wakeup() <= at(60));
+	}
+
+	SECTION("Deadlines fire in order") {
+		REQUIRE(wheel.advance(at(60)) == 1);
+		REQUIRE(wheel.advance(at(100)) == 1);
+		REQUIRE(order == std::vector<int>{2, 1});
+		REQUIRE(wheel.size() == 0);
+		REQUIRE(wheel.next_wakeup() == Wheel::TimePoint::max());
+	}
+}
+
+TEST_CASE("Overlapping windows coalesce into shared buckets", "[hsm][timer]") {
+	Wheel wheel;
+	int   fired = 0;
+	for (int i = 0; i < 1000; ++i) { wheel.schedule(at(30000 + i), at(31000 + i), [&] { ++fired; }); }
+	REQUIRE(wheel.buckets() <= 3);
+
+	SECTION("Every timer fires within its own window") {
+		bool within = true;
+		for (long long t = 30000; t <= 32000; ++t) {
+			wheel.advance(at(t));
+			within = within && fired <= t - 30000 + 1 && fired >= std::min<long long>(1000, t - 31000 + 1);
+		}
+		REQUIRE(within);
+		REQUIRE(fired == 1000);
+		REQUIRE(wheel.wakeups() <= 3);
+	}
+
+	SECTION("Without slack every timer needs its own wakeup") {
+		Wheel exact;
+		for (int i = 0; i < 1000; ++i) { exact.schedule(at(30000 + i), at(30000 + i), [&] { ++fired; }); }
+		REQUIRE(exact.buckets() == 1000);
+	}
+}
+
+TEST_CASE("Cancelled timers do not fire", "[hsm][timer]") {
+	Wheel         wheel;
+	int           fired = 0;
+	Wheel::Handle a     = wheel.schedule(at(10), at(20), [&] { ++fired; });
+	Wheel::Handle b     = wheel.schedule(at(10), at(20), [&] { ++fired; });
+	REQUIRE(wheel.cancel(a));
+	REQUIRE_FALSE(wheel.cancel(a));
+
+	SECTION("The rest of the bucket still fires") {
+		REQUIRE(wheel.advance(at(20)) == 1);
+		REQUIRE(fired == 1);
+		REQUIRE_FALSE(wheel.cancel(b));
+	}
+
+	SECTION("A firing callback can cancel its bucket peers") {
+		wheel.schedule(at(10), at(20), [&] { wheel.cancel(b); });
+		REQUIRE(wheel.advance(at(20)) == 1);
+		REQUIRE(fired == 0);
+	}
+}
+
+TEST_CASE("A throwing callback leaves its bucket peers armed", "[hsm][timer]") {
+	Wheel               wheel;
+	int                 fired = 0;
+	const Wheel::Handle a     = wheel.schedule(at(10), at(10), [&] { ++fired; });
+	wheel.schedule(at(10), at(10), [&] { ++fired; });
+	wheel.schedule(at(10), at(10), [] { throw std::runtime_error("callback failed"); });  // Fires first
+
+	REQUIRE_THROWS_AS(wheel.advance(at(10)), std::runtime_error);
+	REQUIRE(fired == 0);
+	REQUIRE(wheel.size() == 2);
+	REQUIRE(wheel.next_wakeup() == at(10));
+
+	REQUIRE(wheel.cancel(a));
+	REQUIRE(wheel.advance(at(10)) == 1);
+	REQUIRE(fired == 1);
+	REQUIRE(wheel.size() == 0);
+}
+
+TEST_CASE("Timers on every wheel level fire in deadline order", "[hsm][timer]") {
+	Wheel                      wheel;
+	std::vector<long long>     order;
+	std::vector<Wheel::Handle> handles;
+	const long long            deadlines[] = {1LL << 36, 300000, 1, 4096, 70, 63, 1LL << 24, 5000};
+	for (long long d : deadlines) { handles.push_back(wheel.schedule(at(d), at(d), [&order, d] { order.push_back(d); })); }
+	REQUIRE(wheel.next_wakeup() == at(1));
+
+	REQUIRE(wheel.advance(at(4095)) == 3);
+	REQUIRE(wheel.next_wakeup() == at(4096));
+	REQUIRE(wheel.cancel(handles[1]));  // 300000 still sits in a coarse slot
+	REQUIRE(wheel.advance(at(1LL << 30)) == 3);
+	REQUIRE(wheel.next_wakeup() == at(1LL << 36));
+	REQUIRE(wheel.advance(at(1LL << 40)) == 1);
+
+	const std::vector<long long> expected = {1, 63, 70, 4096, 5000, 1LL << 24, 1LL << 36};
+	REQUIRE(order == expected);
+	REQUIRE(wheel.size() == 0);
+	REQUIRE(wheel.buckets() == 0);
+}
+
+TEST_CASE("Timers dispatch to machines", "[hsm][timer]") {
+	Machine sm;
+	sm.start(0, [](Scope &s) {
+		s.state(0).handle([](Machine &sm, const BaseEvent &) {
+			sm->timeouts++;
+			sm.transition(1);
+			return hsm::Result::Done;
+		});
+		s.state(1);
+	});
+
+	Wheel wheel;
+	wheel.schedule_dispatch(sm, at(5), at(8), Timeout{});
+	wheel.advance(at(8));
+	REQUIRE(sm->timeouts == 1);
+	REQUIRE(sm.current_state_id() == 1);
+}
+
+TEST_CASE("Timer resolution must be positive", "[hsm][timer]") { REQUIRE_THROWS_AS(Wheel(ms(0)), std::invalid_argument); }
@@ -0,0 +1,103 @@
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct Go {};
+
+struct TopoTraits {
+	using StateID = int;
+	using Event   = Go;
+	struct Context {};
+};
+
+using Machine = hsm::Machine<TopoTraits>;
+using Scope   = hsm::Scope<TopoTraits>;
+using State   = hsm::State<TopoTraits>;
+
+enum { IDLE, WORK, GROUP, INNER, ORPHAN, ORPHAN_CHILD };
+
+hsm::Result go_work(Machine &sm, const Go &) {
+	sm.transition(WORK);
+	return hsm::Result::Done;
+}
+
+hsm::Result go_inner(Machine &sm, const Go &) {
+	sm.transition(INNER);
+	return hsm::Result::Done;
+}
+
+void build(Scope &s) {
+	s.state(IDLE).targets({WORK}).handle(go_work);
+	s.state(WORK).targets({INNER}).handle(go_inner);
+	s.state(GROUP).with([](Scope &s) { s.state(INNER); });
+	s.state(ORPHAN).targets({IDLE}).handle(go_work).with([](Scope &s) { s.state(ORPHAN_CHILD); });
+}
+
+struct Opaque : State {};
+
+}  // namespace
+
+TEST_CASE("Reachability analysis reports unreachable states", "[hsm][topology]") {
+	Machine sm;
+	sm.start(IDLE, build);
+
+	REQUIRE(sm.unreachable_states() == std::vector<int>{ORPHAN, ORPHAN_CHILD});
+
+	SECTION("Unpruned states stay addressable") {
+		sm.transition(ORPHAN_CHILD);
+		REQUIRE(sm.current_state_id() == ORPHAN_CHILD);
+	}
+}
+
+TEST_CASE("Pruning removes unreachable states", "[hsm][topology]") {
+	Machine sm;
+	sm.prune_unreachable(true);
+	sm.start(IDLE, build);
+
+	sm.dispatch(Go{});
+	sm.dispatch(Go{});
+	REQUIRE(sm.current_state_id() == INNER);
+	REQUIRE_THROWS_AS(sm.transition(ORPHAN), std::runtime_error);
+}
+
+TEST_CASE("Pruned machines still intern and insert", "[hsm][topology]") {
+	Machine sm;
+	sm.prune_unreachable(true);
+	sm.start(IDLE, build);
+
+	REQUIRE_THROWS_AS(sm.intern(ORPHAN), std::invalid_argument);
+	REQUIRE(sm.active(sm.intern(IDLE)));
+
+	sm.insert(GROUP, [](Scope &s) { s.state(42); });
+	REQUIRE_THROWS_AS(sm.insert([](Scope &s) { s.state(WORK); }), std::invalid_argument);
+	sm.transition(sm.intern(42));
+	REQUIRE(sm.current_state_id() == 42);
+}
+
+TEST_CASE("Undeclared behaviour keeps every state", "[hsm][topology]") {
+	Machine sm;
+
+	SECTION("A class-based state without targets may go anywhere") {
+		sm.start(IDLE, [](Scope &s) {
+			build(s);
+			s.state<Opaque>(99);
+			s.targets({99});
+		});
+		REQUIRE(sm.unreachable_states().empty());
+	}
+
+	SECTION("No declarations means no analysis") {
+		sm.start(IDLE, [](Scope &s) {
+			s.state(IDLE);
+			s.state(WORK);
+		});
+		REQUIRE(sm.unreachable_states().empty());
+	}
+
+	SECTION("Unknown declared targets are rejected") {
+		REQUIRE_THROWS_AS(sm.start(IDLE, [](Scope &s) { s.state(IDLE).targets({42}); }), std::invalid_argument);
+	}
+}
@@ -0,0 +1,192 @@
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/hsm.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Enable : BaseEvent {};
+struct Probe : BaseEvent {};
+struct Noise : BaseEvent {};
+
+struct EditTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		std::vector<std::string> log;
+	};
+};
+
+using Machine = hsm::Machine<EditTraits>;
+using Scope   = hsm::Scope<EditTraits>;
+
+enum { BASE, IDLE, FEATURE, FEATURE_A, FEATURE_B, EXTRA };
+
+void build(Scope &s) {
+	s.state(BASE).with([](Scope &s) {
+		s.state(IDLE).on_entry([](Machine &sm) { sm->log.push_back("enter Idle"); });
+	});
+}
+
+void feature(Scope &s) {
+	s.state(FEATURE)
+		.on_entry([](Machine &sm) { sm->log.push_back("enter Feature"); })
+		.on_exit([](Machine &sm) { sm->log.push_back("exit Feature"); })
+		.with([](Scope &s) {
+			s.state(FEATURE_B).on_entry([](Machine &sm) { sm->log.push_back("enter B"); });
+			s.state(FEATURE_A).on_entry([](Machine &sm) { sm->log.push_back("enter A"); }).completion(FEATURE_B);
+		});
+}
+
+}  // namespace
+
+TEST_CASE("Subtrees can be inserted into a running machine", "[hsm][edit]") {
+	Machine sm;
+	sm.start(IDLE, build);
+	sm->log.clear();
+
+	sm.insert(BASE, feature);
+	REQUIRE(sm.current_state_id() == IDLE);
+
+	sm.transition(FEATURE_A);
+	REQUIRE(sm.current_state_id() == FEATURE_B);
+	REQUIRE(sm->log == std::vector<std::string>{"enter Feature", "enter A", "enter B"});
+
+	SECTION("Inserted IDs must be unique and the failed insert leaves no trace") {
+		auto clash = [](Scope &s) {
+			s.state(EXTRA);
+			s.state(IDLE);
+		};
+		REQUIRE_THROWS_AS(sm.insert(clash), std::invalid_argument);
+		REQUIRE_THROWS_AS(sm.transition(EXTRA), std::runtime_error);
+	}
+
+	SECTION("Unknown parents are rejected") { REQUIRE_THROWS_AS(sm.insert(EXTRA, feature), std::invalid_argument); }
+}
+
+TEST_CASE("Subtrees can be removed from a running machine", "[hsm][edit]") {
+	Machine sm;
+	sm.start(IDLE, [](Scope &s) {
+		build(s);
+		feature(s);
+	});
+
+	SECTION("Removing the active path is refused") { REQUIRE_THROWS_AS(sm.remove(BASE), std::logic_error); }
+
+	SECTION("Removed states and their descendants disappear") {
+		sm.remove(FEATURE);
+		REQUIRE_THROWS_AS(sm.transition(FEATURE), std::runtime_error);
+		REQUIRE_THROWS_AS(sm.transition(FEATURE_B), std::runtime_error);
+		REQUIRE(sm.current_state_id() == IDLE);
+	}
+
+	SECTION("Completion targets of remaining states are refused") {
+		sm.insert([](Scope &s) { s.state(EXTRA).completion(FEATURE_A); });
+		REQUIRE_THROWS_AS(sm.remove(FEATURE), std::logic_error);
+
+		sm.transition(EXTRA);
+		REQUIRE(sm.current_state_id() == FEATURE_B);
+		REQUIRE(sm->log.back() == "enter B");
+	}
+
+	SECTION("Edits are refused while a handler runs") {
+		sm.insert(IDLE, [](Scope &s) {
+			s.state(EXTRA).handle([](Machine &sm, const BaseEvent &) {
+				sm.remove(FEATURE);
+				return hsm::Result::Done;
+			});
+		});
+		sm.transition(EXTRA);
+		REQUIRE_THROWS_AS(sm.dispatch(Probe{}), std::logic_error);
+	}
+}
+
+TEST_CASE("Inserted states join existing accept filters", "[hsm][edit]") {
+	Machine sm;
+	sm.start(IDLE, [](Scope &s) { s.state(IDLE).accepts<>(); });
+
+	sm.dispatch(Enable{});
+	REQUIRE(sm.stats().unhandleable == 1);
+
+	sm.insert(IDLE, [](Scope &s) {
+		s.state(FEATURE).accepts<Enable>().handle([](Machine &sm, const BaseEvent &) {
+			sm->log.push_back("enabled");
+			return hsm::Result::Done;
+		});
+	});
+	sm.transition(FEATURE);
+	sm.dispatch(Enable{});
+	sm.dispatch(Probe{});
+
+	REQUIRE(sm->log == std::vector<std::string>{"enabled"});
+	REQUIRE(sm.stats().unhandleable == 2);
+}
+
+TEST_CASE("A failed insert leaves the parent's declarations alone", "[hsm][edit]") {
+	Machine sm;
+	sm.start(IDLE, [](Scope &s) {
+		s.state(IDLE).handle([](Machine &sm, const BaseEvent &) {
+			sm->log.push_back("idle");
+			return hsm::Result::Done;
+		});
+	});
+
+	auto clash = [](Scope &s) {
+		s.accepts<>();
+		s.state(EXTRA);
+		s.state(EXTRA);
+	};
+	REQUIRE_THROWS_AS(sm.insert(IDLE, clash), std::invalid_argument);
+
+	sm.insert(IDLE, [](Scope &s) { s.state(FEATURE).accepts<Enable>(); });
+	const hsm::StateRef feature = sm.intern(FEATURE);
+	sm.transition(feature);
+	sm.dispatch(Probe{});
+
+	REQUIRE(feature.index == 2);
+	REQUIRE(sm->log == std::vector<std::string>{"idle"});
+	REQUIRE(sm.stats().unhandleable == 0);
+}
+
+TEST_CASE("Inserting under the active leaf refreshes its filters", "[hsm][edit]") {
+	auto named = [](const char *name) {
+		return [name](Machine &sm, const BaseEvent &) {
+			sm->log.push_back(name);
+			return hsm::Result::Done;
+		};
+	};
+	Machine sm;
+	sm.start(IDLE, [&](Scope &s) {
+		s.state(BASE).accepts<Enable>().handle(named("base")).with([&](Scope &s) { s.state(IDLE).accepts<Probe>().handle(named("idle")); });
+	});
+	sm.dispatch(Enable{});
+	sm.dispatch(Probe{});
+
+	SECTION("A type only the new child accepts waits until the child is active") {
+		sm.insert(IDLE, [&](Scope &s) {
+			s.state(FEATURE).accepts<Enable, Probe>().with([&](Scope &s) { s.state(EXTRA).accepts<Noise>().handle(named("extra")); });
+		});
+		sm.dispatch(Noise{});
+		REQUIRE(sm.stats().unhandleable == 1);
+
+		sm.transition(EXTRA);
+		sm.dispatch(Noise{});
+		REQUIRE(sm->log == std::vector<std::string>{"base", "idle", "extra"});
+		REQUIRE(sm.stats().unhandleable == 1);
+	}
+
+	SECTION("Types declared for the parent itself reach its handler at once") {
+		sm.insert(IDLE, [&](Scope &s) {
+			s.accepts<Enable, Noise>();
+			s.state(FEATURE).accepts<Noise>();
+		});
+		sm.dispatch(Enable{});
+		sm.dispatch(Noise{});
+		REQUIRE(sm->log == std::vector<std::string>{"base", "idle", "idle", "idle"});
+		REQUIRE(sm.stats().unhandleable == 0);
+	}
+}
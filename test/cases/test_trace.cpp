@@ -0,0 +1,197 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/trace.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Toggle : BaseEvent {};
+struct Noise : BaseEvent {};
+
+struct TraceTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {};
+};
+
+using Machine = hsm::Machine<TraceTraits>;
+using Scope   = hsm::Scope<TraceTraits>;
+using Encoder = hsm::TraceEncoder<TraceTraits>;
+
+std::int64_t fake_now = 0;
+std::int64_t fake_clock() { return fake_now += 1000; }
+
+template <int Next>
+hsm::Result toggle(Machine &sm, const BaseEvent &ev) {
+	return hsm::match(sm, ev).on<Toggle>([](Machine &sm, const Toggle &) {
+		sm.transition(Next);
+		return hsm::Result::Done;
+	});
+}
+
+void build(Scope &s) {
+	s.state(0).name("Off").handle(toggle<1>);
+	s.state(1).name("On").handle(toggle<0>);
+}
+
+// Logs observer callbacks in order: 'd'ispatch, 't'ransition, 's'tep, 'x' for stop
+struct Recorder : hsm::Observer<TraceTraits> {
+	std::string calls;
+
+	void on_dispatch(const Machine &, const BaseEvent &, std::size_t) override { calls += 'd'; }
+	void on_transition(const Machine &, const hsm::State<TraceTraits> *, const hsm::State<TraceTraits> *) override { calls += 't'; }
+	void on_step(const Machine &) override { calls += 's'; }
+	void on_stop(const Machine &) override { calls += 'x'; }
+};
+
+std::vector<hsm::TraceRecord> decode_all(hsm::TraceDecoder &decoder) {
+	std::vector<hsm::TraceRecord> records;
+	hsm::TraceRecord              r;
+	while (decoder.next(r)) { records.push_back(r); }
+	return records;
+}
+
+}  // namespace
+
+TEST_CASE("Trace round-trips through the decoder", "[hsm][trace]") {
+	fake_now = 0;
+	Encoder encoder(fake_clock);
+	Machine sm;
+	sm.observe(encoder);
+	sm.start(0, build);
+	sm.dispatch(Toggle{});
+	sm.dispatch(Noise{});
+
+	hsm::TraceDecoder decoder;
+	decoder.feed(encoder.bytes().data(), encoder.bytes().size());
+	auto records = decode_all(decoder);
+
+	REQUIRE(records.size() == 6);
+	REQUIRE(records[0].kind == hsm::TraceKind::Transition);
+	REQUIRE(records[0].from == 0);
+	REQUIRE(decoder.state_name(records[0].to) == "Off");
+
+	REQUIRE(records[1].kind == hsm::TraceKind::Dispatch);
+	REQUIRE(records[1].event == 0);
+	REQUIRE(decoder.event_name(records[1].event) == typeid(Toggle).name());
+	REQUIRE(records[4].event == 1);
+	REQUIRE(decoder.event_name(records[4].event) == typeid(Noise).name());
+	REQUIRE(records[2].kind == hsm::TraceKind::Transition);
+	REQUIRE(decoder.state_name(records[2].to) == "On");
+	REQUIRE(records[3].kind == hsm::TraceKind::Step);
+	REQUIRE(records[3].handled);
+
+	REQUIRE(records[5].kind == hsm::TraceKind::Step);
+	REQUIRE_FALSE(records[5].handled);
+
+	for (std::size_t i = 0; i < records.size(); ++i) { REQUIRE(records[i].time == std::int64_t(i + 1) * 1000); }
+}
+
+TEST_CASE("Trace records are compact", "[hsm][trace]") {
+	fake_now = 0;
+	Encoder encoder(fake_clock);
+	Machine sm;
+	sm.start(0, build);
+	sm.observe(encoder);
+	sm.dispatch(Toggle{});
+	encoder.clear();
+
+	for (int i = 0; i < 1000; ++i) { sm.dispatch(Toggle{}); }
+	// Dispatch, transition and step at 1us spacing: 4 + 5 + 3 bytes
+	REQUIRE(encoder.bytes().size() == 1000 * 12);
+}
+
+TEST_CASE("Trace decoding resumes across split input", "[hsm][trace]") {
+	fake_now = 0;
+	Encoder encoder(fake_clock);
+	Machine sm;
+	sm.observe(encoder);
+	sm.start(0, build);
+	for (int i = 0; i < 10; ++i) { sm.dispatch(Toggle{}); }
+
+	hsm::TraceDecoder whole, split;
+	whole.feed(encoder.bytes().data(), encoder.bytes().size());
+	auto expected = decode_all(whole);
+
+	std::vector<hsm::TraceRecord> records;
+	hsm::TraceRecord              r;
+	for (std::uint8_t b : encoder.bytes()) {
+		split.feed(&b, 1);
+		while (split.next(r)) { records.push_back(r); }
+	}
+
+	REQUIRE(records.size() == expected.size());
+	for (std::size_t i = 0; i < records.size(); ++i) {
+		REQUIRE(records[i].kind == expected[i].kind);
+		REQUIRE(records[i].time == expected[i].time);
+	}
+	REQUIRE(split.state_name(1) == "Off");
+}
+
+TEST_CASE("Malformed traces are rejected", "[hsm][trace]") {
+	hsm::TraceDecoder  decoder;
+	const std::uint8_t junk[] = {7, 0};
+	decoder.feed(junk, sizeof(junk));
+	hsm::TraceRecord r;
+	REQUIRE_THROWS_AS(decoder.next(r), std::runtime_error);
+}
+
+TEST_CASE("Overlong trace varints are rejected", "[hsm][trace]") {
+	hsm::TraceDecoder         decoder;
+	std::vector<std::uint8_t> overlong(1, std::uint8_t(hsm::TraceKind::Step));
+	overlong.insert(overlong.end(), 11, 0x80);
+	decoder.feed(overlong.data(), overlong.size());
+	hsm::TraceRecord r;
+	REQUIRE_THROWS_AS(decoder.next(r), std::runtime_error);
+}
+
+TEST_CASE("Trace event ids are checked against the dictionary", "[hsm][trace]") {
+	hsm::TraceRecord r;
+
+	// An event name far past the dictionary must not size anything from the stream
+	hsm::TraceDecoder  named;
+	const std::uint8_t far[] = {std::uint8_t(hsm::TraceKind::EventName), 0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 1, 'E'};
+	named.feed(far, sizeof(far));
+	REQUIRE_THROWS_AS(named.next(r), std::runtime_error);
+
+	// A dispatch of an id that was never named
+	hsm::TraceDecoder  dispatched;
+	const std::uint8_t unnamed[] = {std::uint8_t(hsm::TraceKind::Dispatch), 1, 0};
+	dispatched.feed(unnamed, sizeof(unnamed));
+	REQUIRE_THROWS_AS(dispatched.next(r), std::runtime_error);
+}
+
+TEST_CASE("Trace names the base event type", "[hsm][trace]") {
+	fake_now = 0;
+	Encoder encoder(fake_clock);
+	Machine sm;
+	sm.observe(encoder);
+	sm.start(0, build);
+	const BaseEvent &ev = Toggle{};
+	sm.dispatch(ev);
+
+	hsm::TraceDecoder decoder;
+	decoder.feed(encoder.bytes().data(), encoder.bytes().size());
+	auto records = decode_all(decoder);
+	REQUIRE(records[1].kind == hsm::TraceKind::Dispatch);
+	REQUIRE(decoder.event_name(records[1].event) == "Event");
+}
+
+TEST_CASE("Observers see no transition after a stop", "[hsm][trace]") {
+	Recorder recorder;
+	Machine  sm;
+	sm.observe(recorder);
+	sm.start(0, [](Scope &s) {
+		s.state(0).handle(toggle<1>);
+		s.state(1).on_entry([](Machine &sm) { sm.stop(); });
+	});
+	sm.dispatch(Toggle{});
+
+	REQUIRE(sm.terminated());
+	REQUIRE(recorder.calls == "tdxs");
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "hsm/watchdog.hpp"
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Slow : BaseEvent {};
+
+struct WatchTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {};
+};
+
+using Machine = hsm::Machine<WatchTraits>;
+using Scope   = hsm::Scope<WatchTraits>;
+
+struct Collected {
+	std::mutex               mutex;
+	std::vector<std::string> reports;
+
+	void add(const hsm::WatchReport &r) {
+		std::lock_guard<std::mutex> lock(mutex);
+		reports.push_back(std::string(r.state) + ":" + r.action);
+	}
+	std::vector<std::string> get() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return reports;
+	}
+};
+
+void nap() { std::this_thread::sleep_for(std::chrono::milliseconds(60)); }
+
+}  // namespace
+
+TEST_CASE("Watchdog reports long-running actions", "[hsm][watchdog]") {
+	Collected     collected;
+	hsm::Watchdog watchdog(std::chrono::milliseconds(20), [&](const hsm::WatchReport &r) { collected.add(r); }, std::chrono::milliseconds(2));
+	watchdog.attach();
+
+	Machine sm;
+	sm.start(0, [](Scope &s) {
+		s.state(0).name("Fast").handle([](Machine &sm, const BaseEvent &) {
+			sm.transition(1);
+			return hsm::Result::Done;
+		});
+		s.state(1).name("Blocking").on_entry([](Machine &) { nap(); }).handle([](Machine &, const BaseEvent &) {
+			nap();
+			return hsm::Result::Done;
+		});
+	});
+
+	SECTION("A fast machine produces no reports") { REQUIRE(collected.get().empty()); }
+
+	SECTION("Each overrunning action is reported once with its state") {
+		sm.dispatch(Slow{});
+		sm.dispatch(Slow{});
+		REQUIRE(collected.get() == std::vector<std::string>{"Blocking:on_entry", "Blocking:handle"});
+	}
+
+	watchdog.detach();
+}
+
+TEST_CASE("Detached threads are not observed", "[hsm][watchdog]") {
+	Collected     collected;
+	hsm::Watchdog watchdog(std::chrono::milliseconds(20), [&](const hsm::WatchReport &r) { collected.add(r); }, std::chrono::milliseconds(2));
+
+	Machine sm;
+	sm.start(0, [](Scope &s) { s.state(0).name("Blocking").on_entry([](Machine &) { nap(); }); });
+
+	REQUIRE(collected.get().empty());
+}
@@ -0,0 +1,156 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "catch.hpp"
+#include "hsm/static.hpp"
+
+// This binary runs alone so that its allocator can be replaced: inside a `HeapFree` block, any call to
+// `operator new` or, where the linker wraps it, to `malloc` aborts the test run
+namespace {
+std::atomic<bool> heap_free{false};
+
+void check_heap() {
+	if (heap_free.load(std::memory_order_relaxed)) {
+		std::fputs("heap allocation inside a heap-free block\n", stderr);
+		std::abort();
+	}
+}
+
+struct HeapFree {
+	HeapFree() { heap_free.store(true); }
+	~HeapFree() { heap_free.store(false); }
+};
+
+void *allocate(std::size_t n) {
+	check_heap();
+	if (void *p = std::malloc(n ? n : 1)) { return p; }
+	throw std::bad_alloc();
+}
+}  // namespace
+
+void *operator new(std::size_t n) { return allocate(n); }
+void *operator new[](std::size_t n) { return allocate(n); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept {
+	check_heap();
+	return std::malloc(n ? n : 1);
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept {
+	check_heap();
+	return std::malloc(n ? n : 1);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+#ifdef HSM_TEST_WRAP_MALLOC
+// Linked with --wrap, so direct C allocations from this binary's code are checked too
+extern "C" {
+void *__real_malloc(std::size_t n);
+void *__real_calloc(std::size_t n, std::size_t size);
+void *__real_realloc(void *p, std::size_t n);
+
+void *__wrap_malloc(std::size_t n) {
+	check_heap();
+	return __real_malloc(n);
+}
+void *__wrap_calloc(std::size_t n, std::size_t size) {
+	check_heap();
+	return __real_calloc(n, size);
+}
+void *__wrap_realloc(void *p, std::size_t n) {
+	check_heap();
+	return __real_realloc(p, n);
+}
+}
+#endif
+
+namespace {
+
+struct BaseEvent {
+	virtual ~BaseEvent() = default;
+};
+struct Tick : BaseEvent {};
+struct Echo : BaseEvent {};
+
+struct StaticTraits {
+	using StateID = int;
+	using Event   = BaseEvent;
+	struct Context {
+		int ticks   = 0;
+		int echoes  = 0;
+		int entries = 0;
+	};
+};
+
+using Machine = hsm::StaticMachine<StaticTraits, 4096>;
+using Base    = hsm::Machine<StaticTraits>;
+using Scope   = hsm::Scope<StaticTraits>;
+
+enum { GROUP, IDLE, BUSY };
+
+struct BusyState : hsm::State<StaticTraits> {
+	void        on_entry(Base &sm) override { sm->entries++; }
+	hsm::Result handle(Base &sm, const BaseEvent &ev) override {
+		return hsm::match(sm, ev).on<Tick>([](Base &sm, const Tick &) {
+			sm->ticks++;
+			sm.dispatch(Echo{});  // Queued until this step ends
+			sm.transition(IDLE);
+			return hsm::Result::Done;
+		});
+	}
+};
+
+void build(Scope &s) {
+	s.state(GROUP)
+		.handle([](Base &sm, const BaseEvent &ev) {
+			return hsm::match(sm, ev).on<Echo>([](Base &sm, const Echo &) {
+				sm->echoes++;
+				return hsm::Result::Done;
+			});
+		})
+		.with([](Scope &s) {
+			s.state(IDLE).handle([](Base &sm, const BaseEvent &ev) {
+				return hsm::match(sm, ev).on<Tick>([](Base &sm, const Tick &) {
+					sm->ticks++;
+					sm.transition(BUSY);
+					return hsm::Result::Done;
+				});
+			});
+			s.state<BusyState>(BUSY);
+		});
+}
+
+}  // namespace
+
+TEST_CASE("Static machine runs without the heap", "[hsm][static]") {
+	static Machine sm;
+
+	{
+		HeapFree guard;
+		sm.start(IDLE, build);
+		for (int i = 0; i < 100; ++i) { sm.dispatch(Tick{}); }
+		sm.transition(BUSY);
+		sm.stop();
+		sm.start(IDLE, build);  // Restarting recycles the arena
+		sm.dispatch(Tick{});
+	}
+
+	REQUIRE(sm->ticks == 101);
+	REQUIRE(sm->echoes == 50);
+	REQUIRE(sm->entries == 52);
+	REQUIRE(sm.current_state_id() == BUSY);
+	REQUIRE(sm.arena().used() > 0);
+	REQUIRE(sm.arena().used() <= 4096);
+}
+
+TEST_CASE("Static machine reports an exhausted arena", "[hsm][static]") {
+	hsm::StaticMachine<StaticTraits, 1024> sm;
+	REQUIRE_THROWS_AS(sm.start(0,
+							   [](Scope &s) {
+								   for (int i = 0; i < 64; ++i) { s.state(i); }
+							   }),
+					  std::bad_alloc);
+}